@@ -0,0 +1,225 @@
+#include "agendamodel.h"
+#include <QColor>
+#include <QFont>
+#include <QSet>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Above this many rows a batch rebuilds the list instead of signalling each row
+const int BulkThreshold = 1000;
+
+}
+
+bool AgendaModel::Row::operator<(const Row& other) const
+{
+    if (dueKey != other.dueKey) return dueKey < other.dueKey;
+    return id < other.id;
+}
+
+AgendaModel::AgendaModel(const TaskStore* store, QObject* parent)
+    : QAbstractListModel(parent), store(store) {}
+
+int AgendaModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : int(rows.size());
+}
+
+QVariant AgendaModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= int(rows.size())) return QVariant();
+
+    const Task* task = store->find(rows[index.row()].id);
+    if (!task) return QVariant();
+
+    switch (role) {
+    case Qt::DisplayRole: {
+        QString displayText = task->title;
+        if (task->dueDate.isValid()) {
+            displayText += QString(" (Due: %1)").arg(task->dueDate.toString("MMM dd, yyyy"));
+        }
+        displayText += QString(" [%1]").arg(task->priority);
+        return displayText;
+    }
+    case Qt::CheckStateRole:
+        return task->completed ? Qt::Checked : Qt::Unchecked;
+    case Qt::ForegroundRole:
+        if (task->completed) return QColor(128, 128, 128);
+        if (task->priority == "High") return QColor(255, 0, 0);
+        if (task->priority == "Medium") return QColor(255, 165, 0);
+        return QColor(0, 128, 0);
+    case Qt::FontRole:
+        if (task->completed) {
+            QFont font;
+            font.setStrikeOut(true);
+            return font;
+        }
+        return QVariant();
+    case TaskIdRole:
+        return QVariant::fromValue(task->id);
+    default:
+        return QVariant();
+    }
+}
+
+bool AgendaModel::setData(const QModelIndex& index, const QVariant& value, int role)
+{
+    if (!index.isValid() || role != Qt::CheckStateRole) return false;
+
+    // The owner of the store applies the change and reports it back through updateTask()
+    emit completionToggled(rows[index.row()].id, value.toInt() == Qt::Checked);
+    return true;
+}
+
+Qt::ItemFlags AgendaModel::flags(const QModelIndex& index) const
+{
+    if (!index.isValid()) return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable | Qt::ItemNeverHasChildren;
+}
+
+TaskId AgendaModel::taskId(int row) const
+{
+    if (row < 0 || row >= int(rows.size())) return TaskId();
+    return rows[row].id;
+}
+
+int AgendaModel::rowOf(const TaskId& taskId) const
+{
+    auto it = dueKeys.constFind(taskId);
+    if (it == dueKeys.constEnd()) return -1;
+    return findRow({it.value(), taskId});
+}
+
+void AgendaModel::reload()
+{
+    beginResetModel();
+    rows.clear();
+    dueKeys.clear();
+    rows.reserve(store->size());
+    dueKeys.reserve(store->size());
+    store->forEach([this](const Task& task) {
+        qint64 key = dueKey(task);
+        rows.push_back({key, task.id});
+        dueKeys.insert(task.id, key);
+    });
+    std::sort(rows.begin(), rows.end());
+    endResetModel();
+}
+
+void AgendaModel::addTasks(const QList<TaskId>& taskIds)
+{
+    QList<Row> added;
+    for (const TaskId& id : taskIds) {
+        const Task* task = store->find(id);
+        if (task && !dueKeys.contains(id)) {
+            added.append({dueKey(*task), id});
+            dueKeys.insert(id, added.last().dueKey);
+        }
+    }
+
+    if (added.size() > BulkThreshold) {
+        beginResetModel();
+        rows.insert(rows.end(), added.begin(), added.end());
+        std::sort(rows.begin(), rows.end());
+        endResetModel();
+        return;
+    }
+
+    for (const Row& row : added) {
+        int position = lowerBound(row);
+        beginInsertRows(QModelIndex(), position, position);
+        rows.insert(rows.begin() + position, row);
+        endInsertRows();
+    }
+}
+
+void AgendaModel::removeTasks(const QList<TaskId>& taskIds)
+{
+    QList<Row> removed;
+    for (const TaskId& id : taskIds) {
+        auto it = dueKeys.find(id);
+        if (it != dueKeys.end()) {
+            removed.append({it.value(), id});
+            dueKeys.erase(it);
+        }
+    }
+
+    if (removed.size() > BulkThreshold) {
+        QSet<TaskId> removedIds;
+        for (const Row& row : removed) {
+            removedIds.insert(row.id);
+        }
+        beginResetModel();
+        rows.erase(std::remove_if(rows.begin(), rows.end(),
+                                  [&removedIds](const Row& row) { return removedIds.contains(row.id); }),
+                   rows.end());
+        endResetModel();
+        return;
+    }
+
+    for (const Row& row : removed) {
+        int position = findRow(row);
+        if (position < 0) continue;
+        beginRemoveRows(QModelIndex(), position, position);
+        rows.erase(rows.begin() + position);
+        endRemoveRows();
+    }
+}
+
+void AgendaModel::updateTask(const TaskId& taskId)
+{
+    const Task* task = store->find(taskId);
+    auto it = dueKeys.find(taskId);
+    if (!task) {
+        removeTasks({taskId});
+        return;
+    }
+    if (it == dueKeys.end()) {
+        addTasks({taskId});
+        return;
+    }
+
+    int position = findRow({it.value(), taskId});
+    if (position < 0) return;
+
+    Row updated = {dueKey(*task), taskId};
+    if (updated.dueKey != it.value()) {
+        // The old row still sits in the list, so positions next to it need no move
+        int target = lowerBound(updated);
+        if (target < position || target > position + 1) {
+            beginMoveRows(QModelIndex(), position, position, QModelIndex(), target);
+            if (target > position) {
+                std::rotate(rows.begin() + position, rows.begin() + position + 1, rows.begin() + target);
+                position = target - 1;
+            } else {
+                std::rotate(rows.begin() + target, rows.begin() + position, rows.begin() + position + 1);
+                position = target;
+            }
+            endMoveRows();
+        }
+        rows[position] = updated;
+        it.value() = updated.dueKey;
+    }
+
+    QModelIndex changed = index(position);
+    emit dataChanged(changed, changed);
+}
+
+qint64 AgendaModel::dueKey(const Task& task)
+{
+    if (!task.dueDate.isValid()) return std::numeric_limits<qint64>::max();
+    return task.dueDate.toMSecsSinceEpoch();
+}
+
+int AgendaModel::findRow(const Row& row) const
+{
+    int position = lowerBound(row);
+    if (position < int(rows.size()) && rows[position].id == row.id) return position;
+    return -1;
+}
+
+int AgendaModel::lowerBound(const Row& row) const
+{
+    return int(std::lower_bound(rows.begin(), rows.end(), row) - rows.begin());
+}
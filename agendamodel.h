@@ -0,0 +1,55 @@
+#ifndef AGENDAMODEL_H
+#define AGENDAMODEL_H
+#include <QAbstractListModel>
+#include <QHash>
+#include <vector>
+#include "taskstore.h"
+
+// Every task as one flat list ordered by due date, tasks without a due date last.
+// The model keeps only the sort keys; titles, dates and completion are read from
+// the store on demand, so it shares the tree's data instead of copying it. Changes
+// arrive per task and touch only the affected rows; large batches reset instead.
+class AgendaModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        TaskIdRole = Qt::UserRole
+    };
+
+    explicit AgendaModel(const TaskStore* store, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+    TaskId taskId(int row) const;
+    int rowOf(const TaskId& taskId) const;
+
+public slots:
+    void reload();
+    void addTasks(const QList<TaskId>& taskIds);
+    void removeTasks(const QList<TaskId>& taskIds);
+    void updateTask(const TaskId& taskId);
+
+signals:
+    void completionToggled(const TaskId& taskId, bool completed);
+
+private:
+    struct Row {
+        qint64 dueKey;
+        TaskId id;
+        bool operator<(const Row& other) const;
+    };
+
+    const TaskStore* store;
+    std::vector<Row> rows;
+    QHash<TaskId, qint64> dueKeys; // Key each listed task was sorted under
+
+    static qint64 dueKey(const Task& task);
+    int findRow(const Row& row) const;
+    int lowerBound(const Row& row) const;
+};
+
+#endif // AGENDAMODEL_H
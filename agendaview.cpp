@@ -0,0 +1,31 @@
+#include "agendaview.h"
+#include "tasktreewidget.h"
+
+AgendaView::AgendaView(TaskTreeWidget* tree, QWidget* parent)
+    : QListView(parent), agendaModel(new AgendaModel(&tree->getStore(), this))
+{
+    setModel(agendaModel);
+    setUniformItemSizes(true); // Row geometry comes from one row, not from all of them
+    setSelectionMode(QAbstractItemView::SingleSelection);
+
+    connect(tree, &TaskTreeWidget::tasksAdded, agendaModel, &AgendaModel::addTasks);
+    connect(tree, &TaskTreeWidget::tasksRemoved, agendaModel, &AgendaModel::removeTasks);
+    connect(tree, &TaskTreeWidget::taskChanged, agendaModel, &AgendaModel::updateTask);
+    connect(tree, &TaskTreeWidget::tasksReset, agendaModel, &AgendaModel::reload);
+    connect(agendaModel, &AgendaModel::completionToggled, tree, &TaskTreeWidget::setTaskCompleted);
+    connect(selectionModel(), &QItemSelectionModel::currentChanged, this, [this](const QModelIndex& current) {
+        emit taskSelected(agendaModel->taskId(current.row()));
+    });
+
+    agendaModel->reload();
+}
+
+TaskId AgendaView::getSelectedTaskId() const
+{
+    return agendaModel->taskId(currentIndex().row());
+}
+
+void AgendaView::reload()
+{
+    agendaModel->reload();
+}
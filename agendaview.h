@@ -0,0 +1,27 @@
+#ifndef AGENDAVIEW_H
+#define AGENDAVIEW_H
+#include <QListView>
+#include "agendamodel.h"
+
+class TaskTreeWidget;
+
+// Flat due-date list of the tree's tasks. Only the rows on screen are laid out
+// and painted, so scrolling stays cheap however many tasks there are; edits in
+// the tree reach it through the tree's per-task change signals.
+class AgendaView : public QListView
+{
+    Q_OBJECT
+
+public:
+    explicit AgendaView(TaskTreeWidget* tree, QWidget* parent = nullptr);
+    TaskId getSelectedTaskId() const;
+    void reload();
+
+signals:
+    void taskSelected(const TaskId& taskId);
+
+private:
+    AgendaModel* agendaModel;
+};
+
+#endif // AGENDAVIEW_H
@@ -0,0 +1,80 @@
+#include "allocationcounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<quint64> allocationCount{0};
+std::atomic<qint64> liveCount{0};
+
+}
+
+quint64 AllocationCounter::allocations() { return allocationCount.load(); }
+qint64 AllocationCounter::liveBlocks() { return liveCount.load(); }
+
+#if defined(__GLIBC__)
+
+// Interpose the C allocator; operator new and Qt's qMalloc both end up here
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* block, size_t size);
+void __libc_free(void* block);
+
+void* malloc(size_t size) __THROW
+{
+    allocationCount++;
+    liveCount++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) __THROW
+{
+    allocationCount++;
+    liveCount++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* block, size_t size) __THROW
+{
+    if (!block) {
+        liveCount++;
+    } else if (size == 0) {
+        liveCount--;
+    }
+    allocationCount++;
+    return __libc_realloc(block, size);
+}
+
+void free(void* block) __THROW
+{
+    if (block) liveCount--;
+    __libc_free(block);
+}
+
+}
+
+#else
+
+void* operator new(size_t size)
+{
+    allocationCount++;
+    liveCount++;
+    if (void* block = std::malloc(size ? size : 1)) return block;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* block) noexcept
+{
+    if (block) liveCount--;
+    std::free(block);
+}
+
+void operator delete(void* block, size_t) noexcept
+{
+    operator delete(block);
+}
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+#include <QtGlobal>
+
+// Process-wide heap allocation counts for the benchmarks. Linking
+// allocationcounter.cpp replaces malloc (with glibc) or the global operator new
+// (elsewhere), so Qt's own container and string allocations are included.
+namespace AllocationCounter
+{
+    quint64 allocations();
+    qint64 liveBlocks();
+}
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,106 @@
+#include "taskcolumns.h"
+#include <QElapsedTimer>
+#include <QTextStream>
+
+// Times one compound filter - pending, High priority, due within the next week
+// and at most one level deep - over a generated board: first task by task over
+// the records, then over TaskColumns at each instruction set the CPU supports.
+// Every variant must select the same number of tasks.
+//
+// Usage: columnbench [task count] [repeats]
+
+namespace {
+
+const char* const Priorities[] = {"Low", "Medium", "High"};
+
+QList<Task> generateTasks(int count, const QDateTime& now)
+{
+    QList<Task> tasks;
+    tasks.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Task task(QString("Task %1").arg(i), QString(), now.addSecs(qint64(i % 5000) * 3600 - 3600 * 24),
+                  Priorities[(i / 7) % 3]);
+        task.id = TaskId::create();
+        task.level = i % 4;
+        task.completed = i % 3 == 0;
+        tasks.append(task);
+    }
+    return tasks;
+}
+
+const char* isaName(TaskColumns::Isa isa)
+{
+    switch (isa) {
+    case TaskColumns::Avx2: return "avx2";
+    case TaskColumns::Sse2: return "sse2";
+    default: return "scalar";
+    }
+}
+
+// Best of several runs, so one page fault or preemption does not decide it
+template<typename Function>
+double bestMs(int repeats, Function function)
+{
+    double best = 0;
+    for (int i = 0; i < repeats; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        function();
+        double ms = timer.nsecsElapsed() / 1e6;
+        if (i == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    int taskCount = argc > 1 ? QString(argv[1]).toInt() : 1000000;
+    int repeats = argc > 2 ? qMax(1, QString(argv[2]).toInt()) : 20;
+    QTextStream out(stdout);
+
+    QDateTime now = QDateTime::currentDateTime();
+    QDateTime weekAhead = now.addDays(7);
+    QList<Task> tasks = generateTasks(taskCount, now);
+
+    TaskColumns columns;
+    for (const Task& task : tasks) {
+        columns.addTask(task);
+    }
+    out << "tasks: " << taskCount << ", best of " << repeats << "\n";
+
+    int rowCount = 0;
+    double rowMs = bestMs(repeats, [&] {
+        rowCount = 0;
+        for (const Task& task : tasks) {
+            if (!task.completed && task.priority == "High" && task.level <= 1
+                && task.dueDate >= now && task.dueDate < weekAhead) {
+                rowCount++;
+            }
+        }
+    });
+    out << QString("%1 %2 %3\n").arg(QString("records"), -8).arg(rowMs, 10, 'f', 3).arg(rowCount, 10);
+
+    double scalarMs = 0;
+    for (int level = TaskColumns::Scalar; level <= TaskColumns::bestIsa(); ++level) {
+        columns.setIsa(TaskColumns::Isa(level));
+        int count = 0;
+        double ms = bestMs(repeats, [&] {
+            TaskColumns::Selection selection = columns.pending();
+            selection &= columns.priorityEquals("High");
+            selection &= columns.dueBetween(now, weekAhead);
+            selection &= columns.depthAtMost(1);
+            count = selection.count();
+        });
+        if (level == TaskColumns::Scalar) scalarMs = ms;
+
+        out << QString("%1 %2 %3 %4x vs scalar%5\n")
+                   .arg(QString(isaName(columns.isa())), -8)
+                   .arg(ms, 10, 'f', 3)
+                   .arg(count, 10)
+                   .arg(scalarMs / qMax(ms, 1e-6), 6, 'f', 2)
+                   .arg(QString(count == rowCount ? "" : "  MISMATCH"));
+    }
+    return 0;
+}
@@ -0,0 +1,201 @@
+#include "taskmanager.h"
+#include <QApplication>
+#include <QComboBox>
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QScrollBar>
+#include <QStandardPaths>
+#include <QTextStream>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+// Opens TaskManager on the offscreen platform, loads generated boards of growing
+// size and drives the same slots user input reaches: switching filters, ticking
+// the last open subtask (which completes its parent), adding a subtask, deleting
+// a subtree, scrolling and expanding everything. Each step reports the time from
+// the call until the tree's viewport has finished repainting, plus the process's
+// peak resident set so far.
+//
+// Usage: guibench [board sizes, e.g. 1000,10000,100000]
+
+namespace {
+
+const int TasksPerRoot = 10;
+const int RepaintTimeoutMs = 5000;
+
+class RepaintProbe : public QObject
+{
+public:
+    bool painted = false;
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override
+    {
+        if (event->type() == QEvent::Paint) {
+            painted = true;
+        }
+        return QObject::eventFilter(watched, event);
+    }
+};
+
+qint64 peakRssKb()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return qint64(counters.PeakWorkingSetSize / 1024);
+    }
+    return -1;
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(Q_OS_MACOS)
+    return usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+// Roots with nine subtasks each. The first root's subtasks are all done except
+// the last one, so ticking it completes the root as well.
+QList<Task> generateBoard(int count)
+{
+    QList<Task> tasks;
+    tasks.reserve(count);
+    QDateTime now = QDateTime::currentDateTime();
+    TaskId rootId;
+    for (int i = 0; i < count; ++i) {
+        Task task(QString("Task %1").arg(i), QString(), now.addDays(i % 60 - 10),
+                  i % 3 == 0 ? "High" : "Medium");
+        task.id = TaskId::create();
+        if (i % TasksPerRoot == 0) {
+            rootId = task.id;
+        } else {
+            task.parentId = rootId;
+            task.level = 1;
+            task.setCompleted(i < TasksPerRoot - 1 || i % 4 == 0);
+            tasks[i - i % TasksPerRoot].subtaskIds.append(task.id);
+        }
+        tasks.append(task);
+    }
+    return tasks;
+}
+
+class Runner
+{
+public:
+    Runner(TaskManager* window, QTextStream& out)
+        : out(out)
+    {
+        tree = window->findChild<TaskTreeWidget*>("taskTree");
+        filterCombo = window->findChild<QComboBox*>("filterCombo");
+        tree->viewport()->installEventFilter(&probe);
+    }
+
+    bool isValid() const { return tree && filterCombo; }
+
+    template<typename Function>
+    void measure(int taskCount, const QString& interaction, Function function)
+    {
+        // Start from a quiet event queue so earlier work is not counted
+        QCoreApplication::processEvents();
+        probe.painted = false;
+
+        QElapsedTimer timer;
+        timer.start();
+        function();
+
+        QDeadlineTimer deadline(RepaintTimeoutMs);
+        while (!probe.painted && !deadline.hasExpired()) {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        }
+        QString latency = probe.painted ? QString::number(timer.nsecsElapsed() / 1e6, 'f', 2) : QString("no repaint");
+
+        out << QString("%1 %2 %3 %4\n")
+                   .arg(taskCount, 8)
+                   .arg(interaction, -16)
+                   .arg(latency, 12)
+                   .arg(peakRssKb(), 12);
+        out.flush();
+    }
+
+    void runBoard(int taskCount)
+    {
+        QList<Task> tasks = generateBoard(taskCount);
+        TaskId firstRootId = tasks.isEmpty() ? TaskId() : tasks.first().id;
+        TaskId lastOpenSubtaskId = tasks.size() >= TasksPerRoot ? tasks[TasksPerRoot - 1].id : TaskId();
+        TaskId doomedRootId = tasks.size() > TasksPerRoot ? tasks[TasksPerRoot].id : TaskId();
+
+        measure(taskCount, "load", [&] { tree->setAllTasks(tasks); });
+        measure(taskCount, "filter pending", [&] { filterCombo->setCurrentText("Pending"); });
+        measure(taskCount, "filter all", [&] { filterCombo->setCurrentText("All Tasks"); });
+        measure(taskCount, "toggle cascade", [&] { tree->setTaskCompleted(lastOpenSubtaskId, true); });
+        measure(taskCount, "add subtask", [&] {
+            tree->addSubtask(firstRootId, Task("Benchmark subtask", QString(), QDateTime::currentDateTime()));
+        });
+        measure(taskCount, "delete subtree", [&] { tree->removeTask(doomedRootId); });
+        measure(taskCount, "scroll", [&] {
+            QScrollBar* scrollBar = tree->verticalScrollBar();
+            scrollBar->setValue(scrollBar->maximum() / 2);
+        });
+        tree->collapseAll();
+        measure(taskCount, "expand all", [&] { tree->expandAll(); });
+    }
+
+private:
+    QTextStream& out;
+    TaskTreeWidget* tree = nullptr;
+    QComboBox* filterCombo = nullptr;
+    RepaintProbe probe;
+};
+
+}
+
+int main(int argc, char* argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    // Keep the benchmark's saves away from real task files, and start empty
+    QStandardPaths::setTestModeEnabled(true);
+    QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).removeRecursively();
+
+    QList<int> boardSizes = {1000, 10000, 100000};
+    if (argc > 1) {
+        boardSizes.clear();
+        for (const QString& size : QString(argv[1]).split(',')) {
+            boardSizes.append(size.toInt());
+        }
+    }
+
+    QTextStream out(stdout);
+    TaskManager window;
+    window.show();
+
+    Runner runner(&window, out);
+    if (!runner.isValid()) {
+        out << "TaskManager widgets not found\n";
+        return 1;
+    }
+
+    out << QString("%1 %2 %3 %4\n")
+               .arg(QString("tasks"), 8)
+               .arg(QString("interaction"), -16)
+               .arg(QString("latency ms"), 12)
+               .arg(QString("peak RSS KB"), 12);
+    for (int taskCount : boardSizes) {
+        runner.runBoard(taskCount);
+    }
+    return 0;
+}
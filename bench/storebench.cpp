@@ -0,0 +1,120 @@
+#include "allocationcounter.h"
+#include "slabpool.h"
+#include "taskstore.h"
+#include <QElapsedTimer>
+#include <QMap>
+#include <QTextStream>
+
+// Builds, prunes and clears a generated board in TaskStore and in the QMap the
+// tree kept before it, printing time and heap allocations for each phase. The
+// tasks are generated up front, so only the containers' own allocations count.
+//
+// Usage: storebench [task count]
+
+namespace {
+
+const int TasksPerRoot = 10;
+
+struct Sample {
+    qint64 ms = 0;
+    quint64 allocations = 0;
+};
+
+template<typename Function>
+Sample measure(Function function)
+{
+    quint64 before = AllocationCounter::allocations();
+    QElapsedTimer timer;
+    timer.start();
+    function();
+    Sample sample;
+    sample.ms = timer.elapsed();
+    sample.allocations = AllocationCounter::allocations() - before;
+    return sample;
+}
+
+QList<Task> generateTasks(int count)
+{
+    QList<Task> tasks;
+    tasks.reserve(count);
+    QDateTime now = QDateTime::currentDateTime();
+    TaskId rootId;
+    for (int i = 0; i < count; ++i) {
+        Task task(QString("Task %1").arg(i), QString(), now.addDays(i % 60), "Medium");
+        task.id = TaskId::create();
+        if (i % TasksPerRoot == 0) {
+            rootId = task.id;
+        } else {
+            task.parentId = rootId;
+            task.level = 1;
+            tasks[i - i % TasksPerRoot].subtaskIds.append(task.id);
+        }
+        tasks.append(task);
+    }
+    return tasks;
+}
+
+// Every tenth root together with its subtasks
+bool isPruned(int index)
+{
+    return (index / TasksPerRoot) % 10 == 0;
+}
+
+void report(QTextStream& out, const QString& container, const QString& phase, const Sample& sample, int taskCount)
+{
+    out << QString("%1 %2 %3 %4 %5\n")
+               .arg(container, -10)
+               .arg(phase, -8)
+               .arg(sample.ms, 8)
+               .arg(sample.allocations, 12)
+               .arg(double(sample.allocations) / qMax(taskCount, 1), 10, 'f', 3);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    int taskCount = argc > 1 ? QString(argv[1]).toInt() : 1000000;
+    QTextStream out(stdout);
+
+    QList<Task> tasks = generateTasks(taskCount);
+    out << "tasks: " << taskCount << "\n";
+    out << QString("%1 %2 %3 %4 %5\n")
+               .arg(QString("container"), -10)
+               .arg(QString("phase"), -8)
+               .arg(QString("ms"), 8)
+               .arg(QString("allocations"), 12)
+               .arg(QString("per task"), 10);
+
+    {
+        QMap<TaskId, Task> map;
+        report(out, "QMap", "insert", measure([&] {
+            for (const Task& task : tasks) map.insert(task.id, task);
+        }), taskCount);
+        report(out, "QMap", "prune", measure([&] {
+            for (int i = 0; i < tasks.size(); ++i) {
+                if (isPruned(i)) map.remove(tasks[i].id);
+            }
+        }), taskCount);
+        report(out, "QMap", "clear", measure([&] { map.clear(); }), taskCount);
+    }
+
+    {
+        TaskStore store;
+        report(out, "TaskStore", "insert", measure([&] {
+            for (const Task& task : tasks) store.insert(task);
+        }), taskCount);
+
+        SlabPool::Statistics pool = SlabPool::shared().statistics();
+        report(out, "TaskStore", "prune", measure([&] {
+            for (int i = 0; i < tasks.size(); ++i) {
+                if (isPruned(i)) store.remove(tasks[i].id);
+            }
+        }), taskCount);
+        report(out, "TaskStore", "clear", measure([&] { store.clear(); }), taskCount);
+
+        out << "slab pool after insert: " << pool.slabs << " slabs, " << pool.usedBlocks
+            << " blocks in use, " << pool.freeBlocks << " free\n";
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include "deadlinequeue.h"
+
+void DeadlineQueue::clear()
+{
+    heap.clear();
+    positions.clear();
+}
+
+void DeadlineQueue::set(const TaskId& taskId, qint64 when)
+{
+    auto it = positions.constFind(taskId);
+    if (it == positions.constEnd()) {
+        heap.push_back({when, taskId});
+        positions.insert(taskId, int(heap.size()) - 1);
+        siftUp(int(heap.size()) - 1);
+        return;
+    }
+
+    int index = it.value();
+    qint64 before = heap[index].when;
+    heap[index].when = when;
+    if (when < before) {
+        siftUp(index);
+    } else {
+        siftDown(index);
+    }
+}
+
+void DeadlineQueue::remove(const TaskId& taskId)
+{
+    auto it = positions.find(taskId);
+    if (it == positions.end()) return;
+
+    int index = it.value();
+    positions.erase(it);
+
+    // Fill the hole with the last entry and let it settle either way
+    Entry last = heap.back();
+    heap.pop_back();
+    if (index < int(heap.size())) {
+        place(index, last);
+        siftUp(index);
+        siftDown(positions.value(last.taskId));
+    }
+}
+
+bool DeadlineQueue::contains(const TaskId& taskId) const
+{
+    return positions.contains(taskId);
+}
+
+bool DeadlineQueue::isEmpty() const
+{
+    return heap.empty();
+}
+
+int DeadlineQueue::size() const
+{
+    return int(heap.size());
+}
+
+qint64 DeadlineQueue::nextTime() const
+{
+    return heap.front().when;
+}
+
+TaskId DeadlineQueue::nextTask() const
+{
+    return heap.front().taskId;
+}
+
+TaskId DeadlineQueue::takeNext()
+{
+    TaskId taskId = heap.front().taskId;
+    remove(taskId);
+    return taskId;
+}
+
+void DeadlineQueue::place(int index, const Entry& entry)
+{
+    heap[index] = entry;
+    positions.insert(entry.taskId, index);
+}
+
+void DeadlineQueue::siftUp(int index)
+{
+    Entry entry = heap[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (heap[parent].when <= entry.when) break;
+        place(index, heap[parent]);
+        index = parent;
+    }
+    place(index, entry);
+}
+
+void DeadlineQueue::siftDown(int index)
+{
+    Entry entry = heap[index];
+    int count = int(heap.size());
+    while (true) {
+        int child = 2 * index + 1;
+        if (child >= count) break;
+        if (child + 1 < count && heap[child + 1].when < heap[child].when) {
+            child++;
+        }
+        if (entry.when <= heap[child].when) break;
+        place(index, heap[child]);
+        index = child;
+    }
+    place(index, entry);
+}
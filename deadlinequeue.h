@@ -0,0 +1,39 @@
+#ifndef DEADLINEQUEUE_H
+#define DEADLINEQUEUE_H
+#include <QHash>
+#include <vector>
+#include "taskid.h"
+
+// Binary min-heap of one deadline (ms since the epoch) per task, with each
+// task's heap position indexed. Setting, moving or dropping a deadline is
+// O(log n) and the earliest one is read in O(1), so callers can keep it in
+// step with edits instead of rescanning every task.
+class DeadlineQueue
+{
+public:
+    void clear();
+    void set(const TaskId& taskId, qint64 when);
+    void remove(const TaskId& taskId);
+    bool contains(const TaskId& taskId) const;
+    bool isEmpty() const;
+    int size() const;
+
+    qint64 nextTime() const; // Only valid when not empty
+    TaskId nextTask() const;
+    TaskId takeNext();
+
+private:
+    struct Entry {
+        qint64 when;
+        TaskId taskId;
+    };
+
+    std::vector<Entry> heap;
+    QHash<TaskId, int> positions;
+
+    void place(int index, const Entry& entry);
+    void siftUp(int index);
+    void siftDown(int index);
+};
+
+#endif // DEADLINEQUEUE_H
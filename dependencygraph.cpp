@@ -0,0 +1,294 @@
+#include "dependencygraph.h"
+#include <algorithm>
+
+void DependencyGraph::clear()
+{
+    nodes.clear();
+    byOrder.clear();
+    nextOrder = 0;
+}
+
+QHash<TaskId, QList<TaskId>> DependencyGraph::addTask(const Task& task)
+{
+    QHash<TaskId, QList<TaskId>> rejected;
+    addNode(task);
+    addEdges(task, rejected);
+    return rejected;
+}
+
+QHash<TaskId, QList<TaskId>> DependencyGraph::addTasks(const QList<Task>& tasks)
+{
+    // All nodes first, so edges may point at tasks later in the list
+    QHash<TaskId, QList<TaskId>> rejected;
+    for (const Task& task : tasks) {
+        addNode(task);
+    }
+    for (const Task& task : tasks) {
+        addEdges(task, rejected);
+    }
+    return rejected;
+}
+
+void DependencyGraph::updateTask(const Task& task)
+{
+    auto it = nodes.find(task.id);
+    if (it == nodes.end()) {
+        addTask(task);
+        return;
+    }
+
+    it->dueDate = task.dueDate;
+    if (it->completed == task.completed) return;
+    it->completed = task.completed;
+
+    int delta = task.completed ? -1 : 1;
+    for (const TaskId& dependentId : it->dependents) {
+        nodes[dependentId].pendingBlockers += delta;
+    }
+}
+
+void DependencyGraph::removeTask(const TaskId& taskId)
+{
+    auto it = nodes.find(taskId);
+    if (it == nodes.end()) return;
+
+    for (const TaskId& dependentId : it->dependents) {
+        Node& dependent = nodes[dependentId];
+        dependent.blockers.remove(taskId);
+        if (!it->completed) {
+            dependent.pendingBlockers--;
+        }
+    }
+    for (const TaskId& blockerId : it->blockers) {
+        nodes[blockerId].dependents.remove(taskId);
+    }
+    byOrder[it->order] = TaskId();
+    nodes.erase(it);
+
+    // Renumber once the holes outnumber the tasks
+    if (byOrder.size() > 2 * nodes.size() + 64) {
+        compactOrder();
+    }
+}
+
+bool DependencyGraph::addDependency(const TaskId& blockerId, const TaskId& taskId)
+{
+    if (blockerId == taskId || !nodes.contains(blockerId) || !nodes.contains(taskId)) return false;
+    if (nodes[blockerId].dependents.contains(taskId)) return true;
+
+    // The blocker must come first; only an edge pointing backwards needs work
+    if (nodes[taskId].order < nodes[blockerId].order && !reorder(blockerId, taskId)) {
+        return false;
+    }
+
+    Node& blocker = nodes[blockerId];
+    Node& task = nodes[taskId];
+    blocker.dependents.insert(taskId);
+    task.blockers.insert(blockerId);
+    if (!blocker.completed) {
+        task.pendingBlockers++;
+    }
+    return true;
+}
+
+void DependencyGraph::removeDependency(const TaskId& blockerId, const TaskId& taskId)
+{
+    if (!nodes.contains(blockerId) || !nodes.contains(taskId)) return;
+
+    Node& blocker = nodes[blockerId];
+    Node& task = nodes[taskId];
+    if (!blocker.dependents.remove(taskId)) return;
+
+    task.blockers.remove(blockerId);
+    if (!blocker.completed) {
+        task.pendingBlockers--;
+    }
+}
+
+QList<TaskId> DependencyGraph::blockers(const TaskId& taskId) const
+{
+    auto it = nodes.constFind(taskId);
+    return it == nodes.constEnd() ? QList<TaskId>() : it->blockers.values();
+}
+
+QList<TaskId> DependencyGraph::dependents(const TaskId& taskId) const
+{
+    auto it = nodes.constFind(taskId);
+    return it == nodes.constEnd() ? QList<TaskId>() : it->dependents.values();
+}
+
+bool DependencyGraph::isBlocked(const TaskId& taskId) const
+{
+    auto it = nodes.constFind(taskId);
+    return it != nodes.constEnd() && !it->completed && it->pendingBlockers > 0;
+}
+
+bool DependencyGraph::isReady(const TaskId& taskId) const
+{
+    auto it = nodes.constFind(taskId);
+    return it != nodes.constEnd() && !it->completed && it->pendingBlockers == 0;
+}
+
+QList<TaskId> DependencyGraph::topologicalOrder() const
+{
+    QList<TaskId> ordered;
+    ordered.reserve(nodes.size());
+    for (const TaskId& taskId : byOrder) {
+        if (!taskId.isNull()) {
+            ordered.append(taskId);
+        }
+    }
+    return ordered;
+}
+
+QList<TaskId> DependencyGraph::criticalPath() const
+{
+    // Longest chain of unfinished tasks; among equally long chains, prefer
+    // earlier due dates. One pass in topological order.
+    QHash<TaskId, int> length;
+    QHash<TaskId, TaskId> previous;
+    TaskId end;
+
+    for (const TaskId& taskId : byOrder) {
+        if (taskId.isNull()) continue;
+        const Node& node = *nodes.constFind(taskId);
+        if (node.completed) continue;
+
+        int best = 0;
+        TaskId bestBlocker;
+        for (const TaskId& blockerId : node.blockers) {
+            int blockerLength = length.value(blockerId, 0);
+            if (blockerLength > best || (blockerLength == best && blockerLength > 0 && dueBefore(blockerId, bestBlocker))) {
+                best = blockerLength;
+                bestBlocker = blockerId;
+            }
+        }
+
+        length[taskId] = best + 1;
+        if (!bestBlocker.isNull()) {
+            previous[taskId] = bestBlocker;
+        }
+        if (end.isNull() || length[taskId] > length[end]
+            || (length[taskId] == length[end] && dueBefore(taskId, end))) {
+            end = taskId;
+        }
+    }
+
+    QList<TaskId> path;
+    for (TaskId taskId = end; !taskId.isNull(); taskId = previous.value(taskId)) {
+        path.prepend(taskId);
+    }
+    return path;
+}
+
+void DependencyGraph::addNode(const Task& task)
+{
+    if (nodes.contains(task.id)) {
+        updateTask(task);
+        return;
+    }
+
+    Node node;
+    node.order = nextOrder++;
+    node.completed = task.completed;
+    node.dueDate = task.dueDate;
+    nodes.insert(task.id, node);
+    byOrder.append(task.id);
+}
+
+void DependencyGraph::addEdges(const Task& task, QHash<TaskId, QList<TaskId>>& rejected)
+{
+    for (const TaskId& blockerId : task.blockedBy) {
+        if (!addDependency(blockerId, task.id)) {
+            rejected[task.id].append(blockerId);
+        }
+    }
+}
+
+void DependencyGraph::compactOrder()
+{
+    QList<TaskId> ordered = topologicalOrder();
+    for (int i = 0; i < ordered.size(); ++i) {
+        nodes[ordered[i]].order = i;
+    }
+    byOrder = ordered;
+    nextOrder = ordered.size();
+}
+
+bool DependencyGraph::reorder(const TaskId& blockerId, const TaskId& taskId)
+{
+    int lower = nodes[taskId].order;
+    int upper = nodes[blockerId].order;
+
+    // Forward from the task, staying inside the affected region; reaching the
+    // blocker means the new edge would close a cycle
+    QList<TaskId> forward;
+    QSet<TaskId> seen = {taskId};
+    QList<TaskId> stack = {taskId};
+    while (!stack.isEmpty()) {
+        TaskId id = stack.takeLast();
+        if (id == blockerId) return false;
+        forward.append(id);
+        for (const TaskId& next : nodes[id].dependents) {
+            if (!seen.contains(next) && nodes[next].order < upper) {
+                seen.insert(next);
+                stack.append(next);
+            } else if (next == blockerId) {
+                return false;
+            }
+        }
+    }
+
+    // Backward from the blocker, inside the same region
+    QList<TaskId> backward;
+    seen = {blockerId};
+    stack = {blockerId};
+    while (!stack.isEmpty()) {
+        TaskId id = stack.takeLast();
+        backward.append(id);
+        for (const TaskId& prev : nodes[id].blockers) {
+            if (!seen.contains(prev) && nodes[prev].order > lower) {
+                seen.insert(prev);
+                stack.append(prev);
+            }
+        }
+    }
+
+    // Hand the same positions back out: the blocker's side first, then the task's
+    // side, each keeping its existing relative order
+    auto byOrder = [this](const TaskId& a, const TaskId& b) {
+        return nodes[a].order < nodes[b].order;
+    };
+    std::sort(forward.begin(), forward.end(), byOrder);
+    std::sort(backward.begin(), backward.end(), byOrder);
+
+    QList<int> positions;
+    for (const TaskId& id : backward) {
+        positions.append(nodes[id].order);
+    }
+    for (const TaskId& id : forward) {
+        positions.append(nodes[id].order);
+    }
+    std::sort(positions.begin(), positions.end());
+
+    int next = 0;
+    for (const TaskId& id : backward) {
+        nodes[id].order = positions[next];
+        byOrder[positions[next++]] = id;
+    }
+    for (const TaskId& id : forward) {
+        nodes[id].order = positions[next];
+        byOrder[positions[next++]] = id;
+    }
+    return true;
+}
+
+bool DependencyGraph::dueBefore(const TaskId& taskId, const TaskId& otherId) const
+{
+    if (otherId.isNull()) return true;
+
+    const QDateTime& due = nodes.constFind(taskId)->dueDate;
+    const QDateTime& otherDue = nodes.constFind(otherId)->dueDate;
+    if (!otherDue.isValid()) return due.isValid();
+    return due.isValid() && due < otherDue;
+}
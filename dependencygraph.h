@@ -0,0 +1,56 @@
+#ifndef DEPENDENCYGRAPH_H
+#define DEPENDENCYGRAPH_H
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include "task.h"
+
+// "Blocked by" relations between arbitrary tasks. A topological order is kept
+// up to date as edges are added (Pearce-Kelly): only tasks between the two
+// endpoints' positions are visited and renumbered, and a cycle is detected on
+// the same walk. Each task also counts its unfinished blockers, so ready/blocked
+// checks are O(1). Tasks are also listed by position, so walking them in
+// topological order needs no sort.
+class DependencyGraph
+{
+public:
+    void clear();
+    // Both return the blockers that were refused (unknown ids or a cycle), by task
+    QHash<TaskId, QList<TaskId>> addTask(const Task& task);
+    QHash<TaskId, QList<TaskId>> addTasks(const QList<Task>& tasks);
+    void updateTask(const Task& task);
+    void removeTask(const TaskId& taskId);
+
+    bool addDependency(const TaskId& blockerId, const TaskId& taskId);
+    void removeDependency(const TaskId& blockerId, const TaskId& taskId);
+
+    QList<TaskId> blockers(const TaskId& taskId) const;
+    QList<TaskId> dependents(const TaskId& taskId) const;
+    bool isBlocked(const TaskId& taskId) const;
+    bool isReady(const TaskId& taskId) const;
+    QList<TaskId> topologicalOrder() const;
+    QList<TaskId> criticalPath() const;
+
+private:
+    struct Node {
+        QSet<TaskId> blockers;
+        QSet<TaskId> dependents;
+        int order = 0;
+        int pendingBlockers = 0;
+        bool completed = false;
+        QDateTime dueDate;
+    };
+
+    QHash<TaskId, Node> nodes;
+    QList<TaskId> byOrder; // Indexed by Node::order; removed tasks leave a null id
+    int nextOrder = 0;
+
+    void addNode(const Task& task);
+    void addEdges(const Task& task, QHash<TaskId, QList<TaskId>>& rejected);
+    void compactOrder();
+    bool reorder(const TaskId& blockerId, const TaskId& taskId);
+    bool dueBefore(const TaskId& taskId, const TaskId& otherId) const;
+};
+
+#endif // DEPENDENCYGRAPH_H
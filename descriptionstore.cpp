@@ -0,0 +1,71 @@
+#include "descriptionstore.h"
+#include <QFile>
+#include <QFileInfo>
+
+DescriptionStore::DescriptionStore(int cacheBytes)
+    : cache(cacheBytes) {}
+
+bool DescriptionStore::open(const QString& path)
+{
+    filePath = path;
+    cache.clear();
+
+    QFile file(filePath);
+    return file.open(QIODevice::ReadWrite);
+}
+
+void DescriptionStore::clear()
+{
+    cache.clear();
+    QFile file(filePath);
+    file.resize(0);
+}
+
+bool DescriptionStore::store(Task& task, QString text)
+{
+    task.description.clear();
+    task.descriptionOffset = -1;
+    task.descriptionSize = 0;
+    if (text.isEmpty()) return true;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        // Keep the text inline rather than lose it
+        task.description = text;
+        return false;
+    }
+
+    QByteArray bytes = text.toUtf8();
+    qint64 offset = file.size();
+    if (file.write(bytes) != bytes.size()) {
+        task.description = text;
+        return false;
+    }
+
+    task.descriptionOffset = offset;
+    task.descriptionSize = bytes.size();
+    cache.insert(offset, new QString(text), bytes.size());
+    return true;
+}
+
+QString DescriptionStore::text(const Task& task) const
+{
+    if (!task.hasStoredDescription()) return task.description;
+
+    if (QString* cached = cache.object(task.descriptionOffset)) {
+        return *cached;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(task.descriptionOffset)) {
+        return QString();
+    }
+    QString text = QString::fromUtf8(file.read(task.descriptionSize));
+    cache.insert(task.descriptionOffset, new QString(text), task.descriptionSize);
+    return text;
+}
+
+qint64 DescriptionStore::fileSize() const
+{
+    return QFileInfo(filePath).size();
+}
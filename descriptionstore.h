@@ -0,0 +1,26 @@
+#ifndef DESCRIPTIONSTORE_H
+#define DESCRIPTIONSTORE_H
+#include <QString>
+#include <QCache>
+#include "task.h"
+
+// Task descriptions kept out of line in an append-only UTF-8 blob file.
+// Tasks only carry an offset/size pair; text is read on demand through a
+// small LRU cache.
+class DescriptionStore
+{
+public:
+    explicit DescriptionStore(int cacheBytes = 1024 * 1024);
+
+    bool open(const QString& path);
+    void clear();
+    bool store(Task& task, QString text);
+    QString text(const Task& task) const;
+    qint64 fileSize() const;
+
+private:
+    QString filePath;
+    mutable QCache<qint64, QString> cache;
+};
+
+#endif // DESCRIPTIONSTORE_H
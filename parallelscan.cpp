@@ -0,0 +1,159 @@
+#include "parallelscan.h"
+#include <QtConcurrent>
+#include <memory>
+
+namespace {
+
+struct FilterChunk {
+    TaskStore store;
+    std::shared_ptr<const ParallelScan::Filter> filter;
+    int shard = 0;
+};
+
+struct StatsChunk {
+    TaskStore store;
+    QDate today;
+    int shard = 0;
+};
+
+TaskId rootOf(const TaskStore& store, const Task& task)
+{
+    const Task* current = &task;
+    while (!current->parentId.isNull()) {
+        const Task* parent = store.find(current->parentId);
+        if (!parent) break;
+        current = parent;
+    }
+    return current->id;
+}
+
+ParallelScan::Matches filterChunk(const FilterChunk& chunk)
+{
+    const ParallelScan::Filter& filter = *chunk.filter;
+    ParallelScan::Matches matches;
+    chunk.store.forEachInShard(chunk.shard, [&](const Task& task) {
+        if (filter.hasQuery && !filter.query.contains(task.id)) return;
+        if (!ParallelScan::matchesFilter(task, filter.kind, filter.today, filter.dependencies.get())) return;
+
+        matches.matched.insert(task.id);
+        if (!filter.showAncestors) return;
+
+        // Every visible task already has its whole parent path visible, so stop there
+        matches.visible.insert(task.id);
+        const Task* current = &task;
+        while (!current->parentId.isNull() && !matches.visible.contains(current->parentId)) {
+            current = chunk.store.find(current->parentId);
+            if (!current) break;
+            matches.visible.insert(current->id);
+        }
+    });
+    return matches;
+}
+
+void mergeMatches(ParallelScan::Matches& total, const ParallelScan::Matches& part)
+{
+    total.matched.unite(part.matched);
+    total.visible.unite(part.visible);
+}
+
+TaskStats statsChunk(const StatsChunk& chunk)
+{
+    TaskStats stats;
+    stats.clear(chunk.today);
+    chunk.store.forEachInShard(chunk.shard, [&](const Task& task) {
+        stats.addTask(task, rootOf(chunk.store, task));
+    });
+    return stats;
+}
+
+void mergeStats(TaskStats& total, const TaskStats& part)
+{
+    total.merge(part);
+}
+
+}
+
+QFuture<ParallelScan::Matches> ParallelScan::filter(const TaskStore& store, const Filter& filter)
+{
+    std::shared_ptr<const Filter> shared = std::make_shared<const Filter>(filter);
+    QList<FilterChunk> chunks;
+    for (int shard = 0; shard < store.shardCount(); ++shard) {
+        chunks.append({store, shared, shard});
+    }
+    return QtConcurrent::mappedReduced(chunks, filterChunk, mergeMatches,
+                                       QtConcurrent::OrderedReduce | QtConcurrent::SequentialReduce);
+}
+
+TaskStats ParallelScan::statistics(const TaskStore& store, const QDate& today)
+{
+    QList<StatsChunk> chunks;
+    for (int shard = 0; shard < store.shardCount(); ++shard) {
+        chunks.append({store, today, shard});
+    }
+
+    // The reduce starts from a default TaskStats, so set the date on the final copy
+    TaskStats stats;
+    stats.clear(today);
+    stats.merge(QtConcurrent::blockingMappedReduced(chunks, statsChunk, mergeStats,
+                                                    QtConcurrent::OrderedReduce | QtConcurrent::SequentialReduce));
+    return stats;
+}
+
+ParallelScan::FilterKind ParallelScan::filterKind(const QString& filter)
+{
+    if (filter == "Pending") {
+        return Pending;
+    } else if (filter == "Completed") {
+        return Completed;
+    } else if (filter == "High Priority") {
+        return HighPriority;
+    } else if (filter == "Due Today") {
+        return DueToday;
+    } else if (filter == "Main Tasks Only") {
+        return MainTasksOnly;
+    } else if (filter == "Ready") {
+        return Ready;
+    } else if (filter == "Blocked") {
+        return Blocked;
+    }
+    return AllTasks;
+}
+
+bool ParallelScan::matchesFilter(const Task& task, FilterKind kind, const QDate& today,
+                                 const DependencyGraph* dependencies)
+{
+    switch (kind) {
+    case Pending:
+        return !task.completed;
+    case Completed:
+        return task.completed;
+    case HighPriority:
+        return task.priority == "High";
+    case DueToday:
+        return task.isDueOn(today);
+    case MainTasksOnly:
+        return task.isMainTask();
+    case Ready:
+        return dependencies && dependencies->isReady(task.id);
+    case Blocked:
+        return dependencies && dependencies->isBlocked(task.id);
+    case AllTasks:
+        break;
+    }
+    return true;
+}
+
+bool ParallelScan::matchesFilter(const Task& task, const QString& filter, const DependencyGraph& dependencies)
+{
+    return matchesFilter(task, filterKind(filter), QDate::currentDate(), &dependencies);
+}
+
+bool ParallelScan::matchesSelection(const Task& task, const QString& filter, const TaskColumns& columns,
+                                    const TaskColumns::Selection& selection)
+{
+    // Columns hold one due date per task; a series may also be due on a later occurrence
+    if (filter == "Due Today" && task.recurrence.isRecurring()) {
+        return task.isDueOn(QDate::currentDate());
+    }
+    return columns.contains(selection, task.id);
+}
@@ -0,0 +1,47 @@
+#ifndef PARALLELSCAN_H
+#define PARALLELSCAN_H
+#include <QFuture>
+#include <QSet>
+#include <memory>
+#include "taskstore.h"
+#include "taskstats.h"
+#include "tagindex.h"
+#include "dependencygraph.h"
+#include "taskcolumns.h"
+
+// Whole-store passes split across the global thread pool, one chunk per shard of
+// a TaskStore snapshot. Chunks are merged in shard order, so the result does not
+// depend on which thread finished first. Cancelling a filter pass's future stops
+// it from starting any chunk not yet running.
+class ParallelScan
+{
+public:
+    enum FilterKind { AllTasks, Pending, Completed, HighPriority, DueToday, MainTasksOnly, Ready, Blocked };
+
+    // Everything a filter pass reads besides the store snapshot. Only what the
+    // filter needs is filled in, so starting a pass copies almost nothing.
+    struct Filter {
+        FilterKind kind = AllTasks;
+        QDate today;
+        bool hasQuery = false;
+        TagIndex::Result query;
+        std::shared_ptr<const DependencyGraph> dependencies; // Ready and Blocked only
+        bool showAncestors = false;
+    };
+
+    struct Matches {
+        QSet<TaskId> matched;
+        QSet<TaskId> visible; // Matches plus their ancestors, with Filter::showAncestors
+    };
+
+    static QFuture<Matches> filter(const TaskStore& store, const Filter& filter);
+    static TaskStats statistics(const TaskStore& store, const QDate& today = QDate::currentDate());
+    static FilterKind filterKind(const QString& filter);
+    static bool matchesFilter(const Task& task, FilterKind kind, const QDate& today,
+                              const DependencyGraph* dependencies);
+    static bool matchesFilter(const Task& task, const QString& filter, const DependencyGraph& dependencies);
+    static bool matchesSelection(const Task& task, const QString& filter, const TaskColumns& columns,
+                                 const TaskColumns::Selection& selection);
+};
+
+#endif // PARALLELSCAN_H
@@ -0,0 +1,226 @@
+#include "recurrence.h"
+#include <QJsonArray>
+#include <algorithm>
+
+namespace {
+
+const char* const FrequencyNames[] = {"never", "daily", "weekly", "monthly"};
+
+}
+
+Recurrence::Recurrence(Frequency frequency, int interval, const QDateTime& start, const QDate& until)
+    : freq(start.isValid() ? frequency : Never), step(qMax(1, interval)), anchor(start), endDate(until) {}
+
+bool Recurrence::isRecurring() const { return freq != Never; }
+Recurrence::Frequency Recurrence::frequency() const { return freq; }
+int Recurrence::interval() const { return step; }
+QDateTime Recurrence::start() const { return anchor; }
+QDate Recurrence::until() const { return endDate; }
+
+QString Recurrence::describe() const
+{
+    static const char* const units[] = {"", "day", "week", "month"};
+    if (!isRecurring()) return QString();
+
+    QString unit(units[freq]);
+    QString text = step == 1 ? QString("every %1").arg(unit) : QString("every %1 %2s").arg(step).arg(unit);
+    if (endDate.isValid()) {
+        text += QString(" until %1").arg(endDate.toString("MMM dd, yyyy"));
+    }
+    return text;
+}
+
+QDateTime Recurrence::firstOpen() const
+{
+    if (!isRecurring()) return QDateTime();
+
+    qint64 index = closedThrough.isValid() ? firstIndexFrom(closedThrough.addDays(1)) : 0;
+    for (QDateTime occurrence = at(index); inRange(occurrence.date()); occurrence = at(++index)) {
+        if (!isClosed(occurrence.date())) return occurrence;
+    }
+    return QDateTime();
+}
+
+QList<QDateTime> Recurrence::openBetween(const QDate& from, const QDate& to) const
+{
+    QList<QDateTime> occurrences;
+    if (!isRecurring()) return occurrences;
+
+    qint64 index = firstIndexFrom(from);
+    for (QDateTime occurrence = at(index); occurrence.date() <= to && inRange(occurrence.date());
+         occurrence = at(++index)) {
+        if (!isClosed(occurrence.date())) {
+            occurrences.append(occurrence);
+        }
+    }
+    return occurrences;
+}
+
+bool Recurrence::isOpenOn(const QDate& date) const
+{
+    if (!isRecurring()) return false;
+
+    QDate occurrence = at(firstIndexFrom(date)).date();
+    return occurrence == date && inRange(date) && !isClosed(date);
+}
+
+void Recurrence::close(const QDate& date)
+{
+    if (!isOpenOn(date)) return;
+
+    closedDates.insert(std::lower_bound(closedDates.begin(), closedDates.end(), date), date);
+    fold();
+}
+
+void Recurrence::reopen(const QDate& date)
+{
+    if (!isRecurring() || isOpenOn(date)) return;
+
+    auto it = std::lower_bound(closedDates.begin(), closedDates.end(), date);
+    if (it != closedDates.end() && *it == date) {
+        closedDates.erase(it);
+        return;
+    }
+    if (!closedThrough.isValid() || date > closedThrough) return;
+
+    // Split the folded run: occurrences after this one stay closed one by one
+    qint64 index = firstIndexFrom(date);
+    if (at(index).date() != date) return;
+
+    QList<QDate> later;
+    for (QDate occurrence = at(index + 1).date(); occurrence <= closedThrough; occurrence = at(++index + 1).date()) {
+        later.append(occurrence);
+    }
+    closedDates = later + closedDates;
+    qint64 dateIndex = firstIndexFrom(date);
+    closedThrough = dateIndex > 0 ? at(dateIndex - 1).date() : QDate();
+}
+
+int Recurrence::exceptionCount() const
+{
+    return closedDates.size();
+}
+
+QJsonObject Recurrence::toJson() const
+{
+    QJsonObject obj;
+    obj["frequency"] = FrequencyNames[freq];
+    obj["interval"] = step;
+    obj["start"] = anchor.toString(Qt::ISODate);
+    if (endDate.isValid()) {
+        obj["until"] = endDate.toString(Qt::ISODate);
+    }
+    if (closedThrough.isValid()) {
+        obj["closedThrough"] = closedThrough.toString(Qt::ISODate);
+    }
+    if (!closedDates.isEmpty()) {
+        QJsonArray closedArray;
+        for (const QDate& date : closedDates) {
+            closedArray.append(date.toString(Qt::ISODate));
+        }
+        obj["closed"] = closedArray;
+    }
+    return obj;
+}
+
+Recurrence Recurrence::fromJson(const QJsonObject& obj)
+{
+    Frequency frequency = Never;
+    QString name = obj["frequency"].toString();
+    for (int i = Daily; i <= Monthly; ++i) {
+        if (name == FrequencyNames[i]) {
+            frequency = Frequency(i);
+        }
+    }
+
+    Recurrence recurrence(frequency, obj["interval"].toInt(1),
+                          QDateTime::fromString(obj["start"].toString(), Qt::ISODate),
+                          QDate::fromString(obj["until"].toString(), Qt::ISODate));
+    recurrence.closedThrough = QDate::fromString(obj["closedThrough"].toString(), Qt::ISODate);
+    for (const QJsonValue& value : obj["closed"].toArray()) {
+        QDate date = QDate::fromString(value.toString(), Qt::ISODate);
+        if (date.isValid()) {
+            recurrence.closedDates.append(date);
+        }
+    }
+    std::sort(recurrence.closedDates.begin(), recurrence.closedDates.end());
+    return recurrence;
+}
+
+QDateTime Recurrence::at(qint64 index) const
+{
+    switch (freq) {
+    case Daily:
+        return anchor.addDays(index * step);
+    case Weekly:
+        return anchor.addDays(index * step * 7);
+    case Monthly:
+        return anchor.addMonths(int(index * step));
+    default:
+        return anchor;
+    }
+}
+
+bool Recurrence::inRange(const QDate& date) const
+{
+    return date.isValid() && (!endDate.isValid() || date <= endDate);
+}
+
+qint64 Recurrence::firstIndexFrom(const QDate& date) const
+{
+    // Straight to the right occurrence; no walk over the ones before it
+    QDate first = anchor.date();
+    if (date <= first) return 0;
+
+    if (freq == Monthly) {
+        qint64 months = qint64(date.year() - first.year()) * 12 + date.month() - first.month();
+        qint64 index = qMax<qint64>(0, months / step - 1);
+        while (at(index).date() < date) {
+            index++;
+        }
+        return index;
+    }
+
+    qint64 period = freq == Weekly ? qint64(step) * 7 : step;
+    return (first.daysTo(date) + period - 1) / period;
+}
+
+bool Recurrence::isClosed(const QDate& date) const
+{
+    if (closedThrough.isValid() && date <= closedThrough) return true;
+    return std::binary_search(closedDates.begin(), closedDates.end(), date);
+}
+
+void Recurrence::fold()
+{
+    while (!closedDates.isEmpty()) {
+        QDate next = closedThrough.isValid() ? at(firstIndexFrom(closedThrough.addDays(1))).date() : anchor.date();
+        if (closedDates.first() != next) break;
+        closedThrough = next;
+        closedDates.removeFirst();
+    }
+}
+
+QDataStream& operator<<(QDataStream& out, const Recurrence& recurrence)
+{
+    out << quint8(recurrence.freq) << qint32(recurrence.step) << recurrence.anchor << recurrence.endDate;
+    if (recurrence.isRecurring()) {
+        out << recurrence.closedThrough << recurrence.closedDates;
+    }
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, Recurrence& recurrence)
+{
+    quint8 frequency = 0;
+    qint32 step = 1;
+    in >> frequency >> step >> recurrence.anchor >> recurrence.endDate;
+    recurrence.freq = frequency <= Recurrence::Monthly ? Recurrence::Frequency(frequency) : Recurrence::Never;
+    recurrence.step = qMax(1, int(step));
+    recurrence.closedThrough = QDate();
+    recurrence.closedDates.clear();
+    if (recurrence.isRecurring()) {
+        in >> recurrence.closedThrough >> recurrence.closedDates;
+    }
+    return in;
+}
@@ -0,0 +1,56 @@
+#ifndef RECURRENCE_H
+#define RECURRENCE_H
+#include <QDateTime>
+#include <QJsonObject>
+#include <QDataStream>
+#include <QList>
+
+// Repeat rule of a task: every N days, weeks or months from a start, optionally
+// up to an end date. Occurrences are computed on demand and never stored; only
+// the ones closed (done or skipped) are remembered, and a run of closed ones
+// from the start folds into a single date. A series worked through in order
+// therefore costs the same however long its history is.
+class Recurrence
+{
+public:
+    enum Frequency { Never, Daily, Weekly, Monthly };
+
+    Recurrence() = default;
+    Recurrence(Frequency frequency, int interval, const QDateTime& start, const QDate& until = QDate());
+
+    bool isRecurring() const;
+    Frequency frequency() const;
+    int interval() const;
+    QDateTime start() const;
+    QDate until() const;
+    QString describe() const;
+
+    QDateTime firstOpen() const; // Invalid once every occurrence is closed
+    QList<QDateTime> openBetween(const QDate& from, const QDate& to) const; // Both ends included
+    bool isOpenOn(const QDate& date) const;
+    void close(const QDate& date);
+    void reopen(const QDate& date);
+    int exceptionCount() const;
+
+    QJsonObject toJson() const;
+    static Recurrence fromJson(const QJsonObject& obj);
+
+    friend QDataStream& operator<<(QDataStream& out, const Recurrence& recurrence);
+    friend QDataStream& operator>>(QDataStream& in, Recurrence& recurrence);
+
+private:
+    Frequency freq = Never;
+    int step = 1;
+    QDateTime anchor;
+    QDate endDate;
+    QDate closedThrough;      // Every occurrence up to this date is closed
+    QList<QDate> closedDates; // Closed occurrences after closedThrough, sorted
+
+    QDateTime at(qint64 index) const;
+    bool inRange(const QDate& date) const;
+    qint64 firstIndexFrom(const QDate& date) const;
+    bool isClosed(const QDate& date) const;
+    void fold();
+};
+
+#endif // RECURRENCE_H
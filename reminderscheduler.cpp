@@ -0,0 +1,126 @@
+#include "reminderscheduler.h"
+#include "tasktreewidget.h"
+
+namespace {
+
+// Re-armed at least this often, so a wall clock change or a suspend is noticed
+const qint64 MaxTimerInterval = 60 * 60 * 1000;
+
+}
+
+ReminderScheduler::ReminderScheduler(TaskTreeWidget* tree, QObject* parent)
+    : QObject(parent), tree(tree)
+{
+    // The default coarse timer may be off by 5% of a multi-hour wait
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    connect(&timer, &QTimer::timeout, this, &ReminderScheduler::onTimeout);
+
+    connect(tree, &TaskTreeWidget::tasksAdded, this, &ReminderScheduler::scheduleTasks);
+    connect(tree, &TaskTreeWidget::tasksRemoved, this, &ReminderScheduler::unscheduleTasks);
+    connect(tree, &TaskTreeWidget::taskChanged, this, [this](const TaskId& taskId) {
+        scheduleTasks({taskId});
+    });
+    connect(tree, &TaskTreeWidget::tasksReset, this, &ReminderScheduler::rebuild);
+
+    rebuild();
+}
+
+int ReminderScheduler::leadMinutes() const
+{
+    return int(leadMs / 60000);
+}
+
+void ReminderScheduler::setLeadMinutes(int minutes)
+{
+    qint64 lead = qint64(qMax(0, minutes)) * 60000;
+    if (lead == leadMs) return;
+
+    leadMs = lead;
+    rebuild();
+}
+
+int ReminderScheduler::scheduledCount() const
+{
+    return queue.size();
+}
+
+qint64 ReminderScheduler::nextDeadline(const Task& task, qint64 after) const
+{
+    if (task.completed || !task.dueDate.isValid()) return -1;
+
+    qint64 due = task.dueDate.toMSecsSinceEpoch();
+    if (leadMs > 0 && due - leadMs > after) return due - leadMs;
+    if (due > after) return due;
+    return -1;
+}
+
+void ReminderScheduler::schedule(const TaskId& taskId, qint64 after)
+{
+    const Task* task = tree->getStore().find(taskId);
+    qint64 deadline = task ? nextDeadline(*task, after) : -1;
+    if (deadline < 0) {
+        queue.remove(taskId);
+    } else {
+        queue.set(taskId, deadline);
+    }
+}
+
+void ReminderScheduler::scheduleTasks(const QList<TaskId>& taskIds)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (const TaskId& taskId : taskIds) {
+        schedule(taskId, now);
+    }
+    arm();
+}
+
+void ReminderScheduler::unscheduleTasks(const QList<TaskId>& taskIds)
+{
+    for (const TaskId& taskId : taskIds) {
+        queue.remove(taskId);
+    }
+    arm();
+}
+
+void ReminderScheduler::rebuild()
+{
+    queue.clear();
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    tree->getStore().forEach([this, now](const Task& task) {
+        qint64 deadline = nextDeadline(task, now);
+        if (deadline >= 0) {
+            queue.set(task.id, deadline);
+        }
+    });
+    arm();
+}
+
+void ReminderScheduler::arm()
+{
+    if (queue.isEmpty()) {
+        timer.stop();
+        return;
+    }
+
+    qint64 wait = queue.nextTime() - QDateTime::currentMSecsSinceEpoch();
+    timer.start(int(qBound<qint64>(0, wait, MaxTimerInterval)));
+}
+
+void ReminderScheduler::onTimeout()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    while (!queue.isEmpty() && queue.nextTime() <= now) {
+        qint64 firedAt = queue.nextTime();
+        TaskId taskId = queue.nextTask();
+
+        // Rescheduling from the fired time, not now, keeps a due reminder that was also missed
+        schedule(taskId, firedAt);
+        const Task* task = tree->getStore().find(taskId);
+        if (task) {
+            bool due = firedAt >= task->dueDate.toMSecsSinceEpoch();
+            emit reminder(taskId, due ? DueNow : DueSoon);
+        }
+    }
+    arm();
+}
@@ -0,0 +1,44 @@
+#ifndef REMINDERSCHEDULER_H
+#define REMINDERSCHEDULER_H
+#include <QObject>
+#include <QTimer>
+#include "deadlinequeue.h"
+#include "task.h"
+
+class TaskTreeWidget;
+
+// Reminds about each open task a lead time before its due date and again when it
+// falls due. A task has at most one pending deadline in a DeadlineQueue, updated
+// from the tree's change signals, and a single QTimer is armed for the earliest
+// one. Only a reload walks the whole board.
+class ReminderScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Kind { DueSoon, DueNow };
+
+    explicit ReminderScheduler(TaskTreeWidget* tree, QObject* parent = nullptr);
+    int leadMinutes() const;
+    void setLeadMinutes(int minutes);
+    int scheduledCount() const;
+
+signals:
+    void reminder(const TaskId& taskId, ReminderScheduler::Kind kind);
+
+private:
+    TaskTreeWidget* tree;
+    DeadlineQueue queue;
+    QTimer timer;
+    qint64 leadMs = 15 * 60 * 1000;
+
+    qint64 nextDeadline(const Task& task, qint64 after) const;
+    void schedule(const TaskId& taskId, qint64 after);
+    void scheduleTasks(const QList<TaskId>& taskIds);
+    void unscheduleTasks(const QList<TaskId>& taskIds);
+    void rebuild();
+    void arm();
+    void onTimeout();
+};
+
+#endif // REMINDERSCHEDULER_H
@@ -0,0 +1,92 @@
+#include "slabpool.h"
+#include <new>
+
+SlabPool& SlabPool::shared()
+{
+    // Never destroyed: stores held in other statics may release blocks at exit
+    static SlabPool* pool = new SlabPool;
+    return *pool;
+}
+
+int SlabPool::classIndex(size_t size)
+{
+    if (size == 0) size = 1;
+    return int((size - 1) / Granularity);
+}
+
+void* SlabPool::allocate(size_t size)
+{
+    if (size > MaxBlockSize) return ::operator new(size);
+
+    QMutexLocker locker(&mutex);
+    int index = classIndex(size);
+    SizeClass& sizeClass = classes[index];
+    if (!sizeClass.freeList) {
+        addSlab(sizeClass, (index + 1) * Granularity);
+    }
+
+    FreeBlock* block = sizeClass.freeList;
+    sizeClass.freeList = block->next;
+    sizeClass.freeBlocks--;
+    sizeClass.usedBlocks++;
+    return block;
+}
+
+void SlabPool::deallocate(void* block, size_t size)
+{
+    if (!block) return;
+    if (size > MaxBlockSize) {
+        ::operator delete(block);
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    SizeClass& sizeClass = classes[classIndex(size)];
+    FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+    freeBlock->next = sizeClass.freeList;
+    sizeClass.freeList = freeBlock;
+    sizeClass.freeBlocks++;
+    sizeClass.usedBlocks--;
+}
+
+void SlabPool::trim()
+{
+    QMutexLocker locker(&mutex);
+    for (SizeClass& sizeClass : classes) {
+        if (sizeClass.usedBlocks != 0) continue;
+
+        for (char* slab : sizeClass.slabs) {
+            ::operator delete(slab);
+        }
+        sizeClass.slabs.clear();
+        sizeClass.freeList = nullptr;
+        sizeClass.freeBlocks = 0;
+    }
+}
+
+SlabPool::Statistics SlabPool::statistics() const
+{
+    QMutexLocker locker(&mutex);
+    Statistics result;
+    for (const SizeClass& sizeClass : classes) {
+        result.slabs += qint64(sizeClass.slabs.size());
+        result.usedBlocks += sizeClass.usedBlocks;
+        result.freeBlocks += sizeClass.freeBlocks;
+    }
+    return result;
+}
+
+void SlabPool::addSlab(SizeClass& sizeClass, size_t blockSize)
+{
+    char* slab = static_cast<char*>(::operator new(SlabSize));
+    sizeClass.slabs.push_back(slab);
+
+    // Thread the new blocks onto the free list in address order
+    size_t blockCount = SlabSize / blockSize;
+    for (size_t i = blockCount; i-- > 0;) {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * blockSize);
+        block->next = sizeClass.freeList;
+        sizeClass.freeList = block;
+    }
+    sizeClass.freeBlocks += qint64(blockCount);
+}
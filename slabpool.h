@@ -0,0 +1,73 @@
+#ifndef SLABPOOL_H
+#define SLABPOOL_H
+#include <QMutex>
+#include <QtGlobal>
+#include <cstddef>
+#include <vector>
+
+// Small fixed-size blocks carved from 64 KB slabs, with one free list per 16-byte
+// size class. A freed block goes back on its list and is handed out again before
+// any new slab is allocated; trim() gives all slabs of a size class back at once
+// when none of its blocks is in use. Larger requests go straight to operator new.
+// Blocks may be freed from any thread, since store snapshots die on worker threads.
+class SlabPool
+{
+public:
+    static const size_t Granularity = 16;
+    static const size_t MaxBlockSize = 512;
+    static const size_t SlabSize = 64 * 1024;
+
+    struct Statistics {
+        qint64 slabs = 0;
+        qint64 usedBlocks = 0;
+        qint64 freeBlocks = 0;
+    };
+
+    static SlabPool& shared();
+
+    void* allocate(size_t size);
+    void deallocate(void* block, size_t size);
+    void trim();
+    Statistics statistics() const;
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct SizeClass {
+        FreeBlock* freeList = nullptr;
+        std::vector<char*> slabs;
+        qint64 usedBlocks = 0;
+        qint64 freeBlocks = 0;
+    };
+
+    SizeClass classes[MaxBlockSize / Granularity];
+    mutable QMutex mutex;
+
+    SlabPool() = default;
+    static int classIndex(size_t size);
+    static void addSlab(SizeClass& sizeClass, size_t blockSize);
+};
+
+// Standard allocator over SlabPool::shared(), for containers and allocate_shared
+template<typename T>
+class SlabAllocator
+{
+public:
+    using value_type = T;
+
+    SlabAllocator() = default;
+    template<typename U>
+    SlabAllocator(const SlabAllocator<U>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(SlabPool::shared().allocate(n * sizeof(T))); }
+    void deallocate(T* block, size_t n) { SlabPool::shared().deallocate(block, n * sizeof(T)); }
+
+    template<typename U>
+    bool operator==(const SlabAllocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const SlabAllocator<U>&) const { return false; }
+};
+
+#endif // SLABPOOL_H
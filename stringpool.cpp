@@ -0,0 +1,44 @@
+#include "stringpool.h"
+
+StringPool& StringPool::shared()
+{
+    static StringPool* pool = new StringPool;
+    return *pool;
+}
+
+QString StringPool::intern(const QString& text)
+{
+    if (text.isEmpty()) return QString();
+
+    QMutexLocker locker(&mutex);
+    auto it = strings.constFind(text);
+    if (it != strings.constEnd()) return *it;
+    strings.insert(text);
+    return text;
+}
+
+void StringPool::intern(QStringList& list)
+{
+    for (QString& text : list) {
+        text = intern(text);
+    }
+}
+
+void StringPool::purge()
+{
+    QMutexLocker locker(&mutex);
+    for (auto it = strings.begin(); it != strings.end();) {
+        // Detached means the pool holds the only reference
+        if (it->isDetached()) {
+            it = strings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+int StringPool::size() const
+{
+    QMutexLocker locker(&mutex);
+    return strings.size();
+}
@@ -0,0 +1,29 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+// One shared copy of each string that repeats across tasks, such as priorities
+// and tags. Loading a file interns through here so equal values share their
+// string data; purge() drops the strings no task holds any more, e.g. after a
+// reload.
+class StringPool
+{
+public:
+    static StringPool& shared();
+
+    QString intern(const QString& text);
+    void intern(QStringList& list);
+    void purge();
+    int size() const;
+
+private:
+    QSet<QString> strings;
+    mutable QMutex mutex;
+
+    StringPool() = default;
+};
+
+#endif // STRINGPOOL_H
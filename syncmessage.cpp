@@ -0,0 +1,77 @@
+#include "syncmessage.h"
+#include <QDataStream>
+#include <QCryptographicHash>
+
+namespace {
+
+const quint32 Magic = 0x544b5333; // "TKS3"
+
+}
+
+bool SyncMessage::Version::supersedes(const Version& other) const
+{
+    switch (clock.compare(other.clock)) {
+    case VersionVector::After:
+        return true;
+    case VersionVector::Before:
+    case VersionVector::Equal:
+        return false;
+    case VersionVector::Concurrent:
+        break;
+    }
+
+    if (removed != other.removed) return removed;
+    if (timestamp != other.timestamp) return timestamp > other.timestamp;
+    return peerId > other.peerId;
+}
+
+QByteArray SyncMessage::encode() const
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << Magic << clock << quint32(changes.size());
+    for (const Change& change : changes) {
+        const Version& version = change.version;
+        out << version.clock << version.timestamp << version.peerId << version.removed;
+        if (version.removed) {
+            out << change.task.id;
+        } else {
+            out << change.task << change.index;
+        }
+    }
+    return data;
+}
+
+bool SyncMessage::decode(const QByteArray& data, SyncMessage* message)
+{
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic = 0;
+    quint32 count = 0;
+    in >> magic;
+    if (magic != Magic) return false;
+    in >> message->clock >> count;
+
+    message->changes.clear();
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        Change change;
+        Version& version = change.version;
+        in >> version.clock >> version.timestamp >> version.peerId >> version.removed;
+        if (version.removed) {
+            in >> change.task.id;
+        } else {
+            in >> change.task >> change.index;
+        }
+        message->changes.append(change);
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+QString SyncMessage::serverName(const QString& taskFilePath)
+{
+    // Socket names are short-lived paths on Unix; a digest keeps them within limits
+    QByteArray digest = QCryptographicHash::hash(taskFilePath.toUtf8(), QCryptographicHash::Sha1);
+    return "taskmanager-" + QString::fromLatin1(digest.toHex().left(16));
+}
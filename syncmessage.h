@@ -0,0 +1,43 @@
+#ifndef SYNCMESSAGE_H
+#define SYNCMESSAGE_H
+#include <QByteArray>
+#include <QList>
+#include "task.h"
+#include "versionvector.h"
+
+// A batch of task changes sent between instances that share one data directory.
+// Each change carries the version of the write that produced it, so a receiver
+// can tell a newer write from a stale or concurrent one without any history.
+// Descriptions travel as text: blob offsets mean nothing to another instance
+// once either side rewrites the blob.
+class SyncMessage
+{
+public:
+    struct Version {
+        VersionVector clock; // Writer's clock at the time of the write
+        qint64 timestamp = 0; // Writer's wall clock in ms, only used to break ties
+        quint64 peerId = 0;
+        bool removed = false;
+
+        // Concurrent writes: a removal beats an edit, then the later and finally the
+        // higher peer id wins. Every instance picks the same winner.
+        bool supersedes(const Version& other) const;
+    };
+
+    struct Change {
+        Task task; // Only the id for removals
+        Version version;
+        qint32 index = -1; // Position among the task's siblings, -1 for the end
+    };
+
+    VersionVector clock; // Sender's clock when the message was sent
+    QList<Change> changes;
+
+    QByteArray encode() const;
+    static bool decode(const QByteArray& data, SyncMessage* message);
+
+    // Local socket name the instances working on taskFilePath meet on
+    static QString serverName(const QString& taskFilePath);
+};
+
+#endif // SYNCMESSAGE_H
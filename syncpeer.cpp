@@ -0,0 +1,384 @@
+#include "syncpeer.h"
+#include "tasktreewidget.h"
+#include "descriptionstore.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QRandomGenerator>
+#include <algorithm>
+
+namespace {
+
+// Parents before their subtasks, so a receiver can link each one as it arrives
+void sortByLevel(QList<SyncMessage::Change>& changes)
+{
+    std::stable_sort(changes.begin(), changes.end(),
+                     [](const SyncMessage::Change& a, const SyncMessage::Change& b) {
+                         return a.task.level < b.task.level;
+                     });
+}
+
+}
+
+SyncPeer::SyncPeer(TaskTreeWidget* tree, DescriptionStore* descriptions, const QString& taskFilePath,
+                   QObject* parent)
+    : QObject(parent), tree(tree), descriptions(descriptions)
+{
+    serverName = SyncMessage::serverName(taskFilePath);
+    do {
+        peerId = QRandomGenerator::global()->generate64();
+    } while (peerId == 0);
+
+    // Changes made in one event loop turn go out as one message
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(0);
+    connect(&flushTimer, &QTimer::timeout, this, &SyncPeer::flush);
+
+    retryTimer.setSingleShot(true);
+    connect(&retryTimer, &QTimer::timeout, this, &SyncPeer::connectToHub);
+
+    connect(tree, &TaskTreeWidget::tasksAdded, this, &SyncPeer::onTasksChanged);
+    connect(tree, &TaskTreeWidget::tasksRemoved, this, &SyncPeer::onTasksRemoved);
+    connect(tree, &TaskTreeWidget::taskChanged, this, [this](const TaskId& taskId) {
+        onTasksChanged({taskId});
+    });
+    connect(tree, &TaskTreeWidget::taskMoved, this, [this](const TaskId& taskId) {
+        onTasksChanged({taskId});
+    });
+}
+
+void SyncPeer::start()
+{
+    connectToHub();
+}
+
+bool SyncPeer::isHub() const
+{
+    return server != nullptr;
+}
+
+bool SyncPeer::isInUse(const QString& taskFilePath)
+{
+    // A live hub accepts at once; a socket left behind by a dead one refuses
+    QLocalSocket socket;
+    socket.connectToServer(SyncMessage::serverName(taskFilePath));
+    return socket.waitForConnected(500);
+}
+
+void SyncPeer::connectToHub()
+{
+    hubConnected = false;
+    hubSocket = new QLocalSocket(this);
+    connect(hubSocket, &QLocalSocket::connected, this, &SyncPeer::onHubConnected);
+    connect(hubSocket, &QLocalSocket::disconnected, this, &SyncPeer::onHubLost);
+    connect(hubSocket, &QLocalSocket::readyRead, this, [this]() {
+        readFrames(hubSocket);
+    });
+    connect(hubSocket, &QLocalSocket::errorOccurred, this, [this](QLocalSocket::LocalSocketError error) {
+        if (hubConnected) return; // Losing an established hub is handled by disconnected
+
+        // Nobody is listening; a refused connection means a dead hub left its socket behind
+        hubSocket->deleteLater();
+        hubSocket = nullptr;
+        becomeHub(error == QLocalSocket::ConnectionRefusedError);
+    });
+    hubSocket->connectToServer(serverName);
+}
+
+void SyncPeer::becomeHub(bool removeStaleSocket)
+{
+    server = new QLocalServer(this);
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    if (!server->listen(serverName) && removeStaleSocket) {
+        QLocalServer::removeServer(serverName);
+        server->listen(serverName);
+    }
+
+    if (!server->isListening()) {
+        // Another instance won the race; connect to it instead
+        delete server;
+        server = nullptr;
+        retryTimer.start(QRandomGenerator::global()->bounded(50, 250));
+        return;
+    }
+    connect(server, &QLocalServer::newConnection, this, &SyncPeer::onClientConnected);
+}
+
+void SyncPeer::onHubConnected()
+{
+    // Both sides send what they changed this session; the version check drops what the other already has
+    hubConnected = true;
+    sendFrame(hubSocket, sessionState().encode());
+}
+
+void SyncPeer::onHubLost()
+{
+    hubConnected = false;
+    hubSocket->deleteLater();
+    hubSocket = nullptr;
+
+    // Spread the clients out so one of them becomes the new hub first
+    retryTimer.start(QRandomGenerator::global()->bounded(50, 250));
+}
+
+void SyncPeer::onClientConnected()
+{
+    while (QLocalSocket* client = server->nextPendingConnection()) {
+        clients.append(client);
+        connect(client, &QLocalSocket::readyRead, this, [this, client]() {
+            readFrames(client);
+        });
+        connect(client, &QLocalSocket::disconnected, this, [this, client]() {
+            clients.removeOne(client);
+            client->deleteLater();
+        });
+        sendFrame(client, sessionState().encode());
+    }
+}
+
+void SyncPeer::readFrames(QLocalSocket* socket)
+{
+    QDataStream in(socket);
+    while (true) {
+        in.startTransaction();
+        QByteArray frame;
+        in >> frame;
+        if (!in.commitTransaction()) break; // Rest of the frame has not arrived yet
+
+        SyncMessage message;
+        if (!SyncMessage::decode(frame, &message)) continue;
+        if (server) {
+            broadcast(frame, socket);
+        }
+        apply(message);
+    }
+}
+
+void SyncPeer::sendFrame(QLocalSocket* socket, const QByteArray& frame)
+{
+    QDataStream out(socket);
+    out << frame;
+}
+
+void SyncPeer::broadcast(const QByteArray& frame, QLocalSocket* except)
+{
+    for (QLocalSocket* client : clients) {
+        if (client != except) {
+            sendFrame(client, frame);
+        }
+    }
+}
+
+void SyncPeer::onTasksChanged(const QList<TaskId>& taskIds)
+{
+    if (applying) return; // Echoes of remote changes, including their roll-ups
+
+    for (const TaskId& taskId : taskIds) {
+        changedIds.insert(taskId);
+    }
+    flushTimer.start();
+}
+
+void SyncPeer::onTasksRemoved(const QList<TaskId>& taskIds)
+{
+    if (applying) return;
+
+    for (const TaskId& taskId : taskIds) {
+        changedIds.remove(taskId);
+        removedIds.insert(taskId);
+    }
+    flushTimer.start();
+}
+
+void SyncPeer::flush()
+{
+    if (changedIds.isEmpty() && removedIds.isEmpty()) return;
+
+    clock.increment(peerId);
+    SyncMessage::Version version;
+    version.clock = clock;
+    version.timestamp = QDateTime::currentMSecsSinceEpoch();
+    version.peerId = peerId;
+
+    SyncMessage message;
+    message.clock = clock;
+    const TaskStore& store = tree->getStore();
+    for (const TaskId& taskId : changedIds) {
+        if (const Task* task = store.find(taskId)) {
+            message.changes.append({outgoing(*task), version, tree->getTaskIndex(taskId)});
+            versions.insert(taskId, version);
+        }
+    }
+    sortByLevel(message.changes);
+
+    version.removed = true;
+    for (const TaskId& taskId : removedIds) {
+        SyncMessage::Change change;
+        change.task.id = taskId;
+        change.version = version;
+        message.changes.append(change);
+        versions.insert(taskId, version);
+    }
+    changedIds.clear();
+    removedIds.clear();
+
+    // Without a connection the versions recorded above are sent on the next connect
+    QByteArray frame = message.encode();
+    if (server) {
+        broadcast(frame);
+    } else if (hubConnected) {
+        sendFrame(hubSocket, frame);
+    }
+}
+
+SyncMessage SyncPeer::sessionState() const
+{
+    SyncMessage message;
+    message.clock = clock;
+    const TaskStore& store = tree->getStore();
+    for (auto it = versions.constBegin(); it != versions.constEnd(); ++it) {
+        SyncMessage::Change change;
+        change.version = it.value();
+        if (it.value().removed) {
+            change.task.id = it.key();
+        } else if (const Task* task = store.find(it.key())) {
+            change.task = outgoing(*task);
+            change.index = tree->getTaskIndex(it.key());
+        } else {
+            continue;
+        }
+        message.changes.append(change);
+    }
+    sortByLevel(message.changes);
+    return message;
+}
+
+Task SyncPeer::outgoing(const Task& task) const
+{
+    Task copy = task;
+    copy.description = descriptions->text(task);
+    copy.descriptionOffset = -1;
+    copy.descriptionSize = 0;
+    return copy;
+}
+
+void SyncPeer::storeDescription(Task& task)
+{
+    // Unchanged text keeps the local copy rather than growing the blob on every sync
+    const Task* local = tree->getStore().find(task.id);
+    if (local && descriptions->text(*local) == task.description) {
+        task.description = local->description;
+        task.descriptionOffset = local->descriptionOffset;
+        task.descriptionSize = local->descriptionSize;
+        return;
+    }
+    descriptions->store(task, task.description);
+}
+
+void SyncPeer::apply(const SyncMessage& message)
+{
+    const TaskStore& store = tree->getStore();
+    QList<Task> added;
+    QSet<TaskId> addedIds;
+    QList<Task> updated;
+    QList<TaskId> removed;
+    QList<const SyncMessage::Change*> positioned;
+
+    for (const SyncMessage::Change& change : message.changes) {
+        const TaskId& taskId = change.task.id;
+        auto it = versions.constFind(taskId);
+        if (it != versions.constEnd() && !change.version.supersedes(it.value())) continue;
+        versions.insert(taskId, change.version);
+
+        if (change.version.removed) {
+            if (store.contains(taskId)) {
+                removed.append(taskId);
+            }
+            continue;
+        }
+
+        positioned.append(&change);
+        if (store.contains(taskId)) {
+            Task task = change.task;
+            storeDescription(task);
+            updated.append(task);
+        } else {
+            // A subtask whose parent was removed meanwhile becomes a main task
+            Task task = change.task;
+            storeDescription(task);
+            if (!task.parentId.isNull() && !store.contains(task.parentId) && !addedIds.contains(task.parentId)) {
+                task.parentId = TaskId();
+                task.level = 0;
+            }
+            added.append(task);
+            addedIds.insert(task.id);
+        }
+    }
+    clock.merge(message.clock);
+
+    if (added.isEmpty() && updated.isEmpty() && removed.isEmpty()) return;
+
+    // One refilter for the whole message instead of one per call
+    applying = true;
+    tree->beginBatch();
+    if (!added.isEmpty()) {
+        tree->addTasks(added);
+    }
+    for (const Task& task : updated) {
+        applyUpdate(task);
+    }
+    if (!removed.isEmpty()) {
+        tree->removeTasks(removed);
+    }
+
+    // Parents first, then siblings left to right, so each lands where the sender had it
+    std::stable_sort(positioned.begin(), positioned.end(),
+                     [](const SyncMessage::Change* a, const SyncMessage::Change* b) {
+                         if (a->task.level != b->task.level) return a->task.level < b->task.level;
+                         return a->index < b->index;
+                     });
+    for (const SyncMessage::Change* change : positioned) {
+        applyPosition(change->task.id, change->task.parentId, change->index);
+    }
+    tree->endBatch();
+    applying = false;
+
+    emit remoteChangesApplied();
+}
+
+void SyncPeer::applyUpdate(const Task& task)
+{
+    // Parent and position are applied for the whole message afterwards
+    Task local = tree->getTaskById(task.id);
+    tree->updateTask(task.id, task);
+
+    // updateTask() keeps the old links; dependencies go through the graph's own checks
+    for (const TaskId& blockerId : task.blockedBy) {
+        if (!local.blockedBy.contains(blockerId)) {
+            tree->addDependency(task.id, blockerId);
+        }
+    }
+    for (const TaskId& blockerId : local.blockedBy) {
+        if (!task.blockedBy.contains(blockerId)) {
+            tree->removeDependency(task.id, blockerId);
+        }
+    }
+}
+
+void SyncPeer::applyPosition(const TaskId& taskId, const TaskId& parentId, int index)
+{
+    const TaskStore& store = tree->getStore();
+    const Task* task = store.find(taskId);
+    if (!task) return;
+
+    TaskId newParentId = store.contains(parentId) ? parentId : TaskId();
+    int currentIndex = tree->getTaskIndex(taskId);
+    if (newParentId == task->parentId) {
+        if (index < 0 || index == currentIndex) return;
+
+        // moveTask() takes a drop position, counted before the task leaves its row
+        if (currentIndex < index) {
+            index++;
+        }
+    }
+    tree->moveTask(taskId, newParentId, index);
+}
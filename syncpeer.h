@@ -0,0 +1,72 @@
+#ifndef SYNCPEER_H
+#define SYNCPEER_H
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include "syncmessage.h"
+
+class QLocalServer;
+class QLocalSocket;
+class TaskTreeWidget;
+class DescriptionStore;
+
+// Keeps every instance that works on the same task file in step. The first one
+// to listen on the file's local socket becomes the hub and relays each message
+// to the other peers; the rest connect to it as clients, and race to replace it
+// when it goes away. Only changed tasks travel. A receiver applies each change
+// through the tree's normal mutation calls, so its views update the same way
+// they do for local edits.
+class SyncPeer : public QObject
+{
+    Q_OBJECT
+
+public:
+    SyncPeer(TaskTreeWidget* tree, DescriptionStore* descriptions, const QString& taskFilePath,
+             QObject* parent = nullptr);
+    void start();
+    bool isHub() const;
+
+    // True if another instance is already listening for taskFilePath
+    static bool isInUse(const QString& taskFilePath);
+
+signals:
+    void remoteChangesApplied();
+
+private:
+    TaskTreeWidget* tree;
+    DescriptionStore* descriptions;
+    QString serverName;
+    quint64 peerId;
+    VersionVector clock;
+    QHash<TaskId, SyncMessage::Version> versions; // Winning write per task touched this session
+    QLocalServer* server = nullptr;
+    QLocalSocket* hubSocket = nullptr; // Clients only
+    bool hubConnected = false;
+    QList<QLocalSocket*> clients;      // Hub only
+    QSet<TaskId> changedIds;
+    QSet<TaskId> removedIds;
+    QTimer flushTimer;
+    QTimer retryTimer;
+    bool applying = false;
+
+    void connectToHub();
+    void becomeHub(bool removeStaleSocket);
+    void onHubConnected();
+    void onHubLost();
+    void onClientConnected();
+    void readFrames(QLocalSocket* socket);
+    void sendFrame(QLocalSocket* socket, const QByteArray& frame);
+    void broadcast(const QByteArray& frame, QLocalSocket* except = nullptr);
+    void onTasksChanged(const QList<TaskId>& taskIds);
+    void onTasksRemoved(const QList<TaskId>& taskIds);
+    void flush();
+    SyncMessage sessionState() const;
+    Task outgoing(const Task& task) const;
+    void storeDescription(Task& task);
+    void apply(const SyncMessage& message);
+    void applyUpdate(const Task& task);
+    void applyPosition(const TaskId& taskId, const TaskId& parentId, int index);
+};
+
+#endif // SYNCPEER_H
@@ -0,0 +1,256 @@
+#include "tagindex.h"
+#include <algorithm>
+
+void TagIndex::clear()
+{
+    handles.clear();
+    taskIdsByHandle.clear();
+    freeHandles.clear();
+    allTasks = TaskBitmap();
+    completedTasks = TaskBitmap();
+    tagBitmaps.clear();
+    tagCounts.clear();
+}
+
+void TagIndex::addTask(const Task& task)
+{
+    if (handles.contains(task.id)) {
+        removeTask(task);
+    }
+
+    // Reuse freed handles so the bitmaps stay dense
+    quint32 handle;
+    if (!freeHandles.isEmpty()) {
+        handle = freeHandles.takeLast();
+        taskIdsByHandle[handle] = task.id;
+    } else {
+        handle = quint32(taskIdsByHandle.size());
+        taskIdsByHandle.append(task.id);
+    }
+    handles.insert(task.id, handle);
+
+    allTasks.set(handle);
+    if (task.completed) {
+        completedTasks.set(handle);
+    }
+    for (const QString& tag : task.tags) {
+        addTag(tag, handle);
+    }
+}
+
+void TagIndex::removeTask(const Task& task)
+{
+    auto it = handles.find(task.id);
+    if (it == handles.end()) return;
+
+    quint32 handle = it.value();
+    handles.erase(it);
+
+    // The task's current tags may differ from the caller's copy; clear them all
+    const QStringList allTags = tagBitmaps.keys();
+    for (const QString& tag : allTags) {
+        removeTag(tag, handle);
+    }
+    allTasks.reset(handle);
+    completedTasks.reset(handle);
+
+    taskIdsByHandle[handle] = TaskId();
+    freeHandles.append(handle);
+}
+
+void TagIndex::updateTask(const Task& before, const Task& after)
+{
+    auto it = handles.constFind(after.id);
+    if (it == handles.constEnd()) {
+        addTask(after);
+        return;
+    }
+
+    quint32 handle = it.value();
+    if (after.completed) {
+        completedTasks.set(handle);
+    } else {
+        completedTasks.reset(handle);
+    }
+
+    for (const QString& tag : before.tags) {
+        if (!after.tags.contains(tag)) {
+            removeTag(tag, handle);
+        }
+    }
+    for (const QString& tag : after.tags) {
+        addTag(tag, handle);
+    }
+}
+
+QStringList TagIndex::tags() const
+{
+    QStringList result = tagCounts.keys();
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+int TagIndex::tagCount(const QString& tag) const
+{
+    return tagCounts.value(tag, 0);
+}
+
+bool TagIndex::contains(const TaskBitmap& bitmap, const TaskId& taskId) const
+{
+    auto it = handles.constFind(taskId);
+    return it != handles.constEnd() && bitmap.test(it.value());
+}
+
+QList<TaskId> TagIndex::taskIds(const TaskBitmap& bitmap) const
+{
+    QList<TaskId> ids;
+    bitmap.forEach([this, &ids](quint32 handle) {
+        if (int(handle) < taskIdsByHandle.size()) {
+            ids.append(taskIdsByHandle[int(handle)]);
+        }
+    });
+    return ids;
+}
+
+TagIndex::Result TagIndex::result(const TaskBitmap& bitmap) const
+{
+    Result result;
+    result.handles = handles;
+    result.bitmap = bitmap;
+    return result;
+}
+
+bool TagIndex::Result::contains(const TaskId& taskId) const
+{
+    auto it = handles.constFind(taskId);
+    return it != handles.constEnd() && bitmap.test(it.value());
+}
+
+TaskBitmap TagIndex::evaluate(const QString& query, QString* error) const
+{
+    QStringList tokens = tokenize(query);
+    int pos = 0;
+    QString message;
+
+    TaskBitmap result = parseOr(tokens, pos, message);
+    if (message.isEmpty() && pos < tokens.size()) {
+        message = QString("Unexpected \"%1\"").arg(tokens[pos]);
+    }
+
+    if (error) {
+        *error = message;
+    }
+    return message.isEmpty() ? result : TaskBitmap();
+}
+
+void TagIndex::addTag(const QString& tag, quint32 handle)
+{
+    TaskBitmap& bitmap = tagBitmaps[tag];
+    if (!bitmap.test(handle)) {
+        bitmap.set(handle);
+        tagCounts[tag]++;
+    }
+}
+
+void TagIndex::removeTag(const QString& tag, quint32 handle)
+{
+    auto it = tagBitmaps.find(tag);
+    if (it == tagBitmaps.end() || !it.value().test(handle)) return;
+
+    it.value().reset(handle);
+    if (--tagCounts[tag] == 0) {
+        tagCounts.remove(tag);
+        tagBitmaps.erase(it);
+    }
+}
+
+QStringList TagIndex::tokenize(const QString& query)
+{
+    QStringList tokens;
+    QString current;
+    for (const QChar ch : query) {
+        if (ch.isSpace() || ch == '(' || ch == ')') {
+            if (!current.isEmpty()) {
+                tokens.append(current);
+                current.clear();
+            }
+            if (!ch.isSpace()) {
+                tokens.append(QString(ch));
+            }
+        } else {
+            current += ch;
+        }
+    }
+    if (!current.isEmpty()) {
+        tokens.append(current);
+    }
+    return tokens;
+}
+
+TaskBitmap TagIndex::parseOr(const QStringList& tokens, int& pos, QString& error) const
+{
+    TaskBitmap result = parseAnd(tokens, pos, error);
+    while (error.isEmpty() && pos < tokens.size() && tokens[pos].compare("OR", Qt::CaseInsensitive) == 0) {
+        pos++;
+        result = result | parseAnd(tokens, pos, error);
+    }
+    return result;
+}
+
+TaskBitmap TagIndex::parseAnd(const QStringList& tokens, int& pos, QString& error) const
+{
+    TaskBitmap result = parseNot(tokens, pos, error);
+    while (error.isEmpty() && pos < tokens.size() && tokens[pos] != ")"
+           && tokens[pos].compare("OR", Qt::CaseInsensitive) != 0) {
+        // "AND" is optional between terms
+        if (tokens[pos].compare("AND", Qt::CaseInsensitive) == 0) {
+            pos++;
+        }
+        result = result & parseNot(tokens, pos, error);
+    }
+    return result;
+}
+
+TaskBitmap TagIndex::parseNot(const QStringList& tokens, int& pos, QString& error) const
+{
+    if (pos < tokens.size() && tokens[pos].compare("NOT", Qt::CaseInsensitive) == 0) {
+        pos++;
+        return allTasks.andNot(parseNot(tokens, pos, error));
+    }
+    return parseTerm(tokens, pos, error);
+}
+
+TaskBitmap TagIndex::parseTerm(const QStringList& tokens, int& pos, QString& error) const
+{
+    if (pos >= tokens.size()) {
+        error = "Incomplete query";
+        return TaskBitmap();
+    }
+
+    QString token = tokens[pos++];
+    if (token == "(") {
+        TaskBitmap result = parseOr(tokens, pos, error);
+        if (error.isEmpty()) {
+            if (pos < tokens.size() && tokens[pos] == ")") {
+                pos++;
+            } else {
+                error = "Missing \")\"";
+            }
+        }
+        return result;
+    }
+
+    QString term = token.toLower();
+    if (term.startsWith("tag:")) {
+        return tagBitmaps.value(term.mid(4));
+    } else if (term == "done" || term == "completed") {
+        return completedTasks;
+    } else if (term == "pending") {
+        return allTasks.andNot(completedTasks);
+    } else if (term == "all") {
+        return allTasks;
+    }
+
+    error = QString("Unknown term \"%1\"").arg(token);
+    return TaskBitmap();
+}
@@ -0,0 +1,61 @@
+#ifndef TAGINDEX_H
+#define TAGINDEX_H
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include "task.h"
+#include "taskbitmap.h"
+
+// Bitmap index from tags (and completion) to dense task handles. Queries such as
+// "tag:backend AND tag:urgent AND NOT done" are evaluated with bitmap set algebra.
+// Terms: tag:<name>, done, pending, all; operators: AND (or juxtaposition), OR,
+// NOT and parentheses.
+class TagIndex
+{
+public:
+    // A query result that can be tested without the index, e.g. on another thread.
+    // It shares the index's handle table until the index next changes.
+    class Result
+    {
+    public:
+        bool contains(const TaskId& taskId) const;
+
+    private:
+        friend class TagIndex;
+        QHash<TaskId, quint32> handles;
+        TaskBitmap bitmap;
+    };
+
+    void clear();
+    void addTask(const Task& task);
+    void removeTask(const Task& task);
+    void updateTask(const Task& before, const Task& after);
+
+    QStringList tags() const;
+    int tagCount(const QString& tag) const;
+    bool contains(const TaskBitmap& bitmap, const TaskId& taskId) const;
+    QList<TaskId> taskIds(const TaskBitmap& bitmap) const;
+    TaskBitmap evaluate(const QString& query, QString* error = nullptr) const;
+    Result result(const TaskBitmap& bitmap) const;
+
+private:
+    QHash<TaskId, quint32> handles;
+    QVector<TaskId> taskIdsByHandle;
+    QVector<quint32> freeHandles;
+    TaskBitmap allTasks;
+    TaskBitmap completedTasks;
+    QHash<QString, TaskBitmap> tagBitmaps;
+    QHash<QString, int> tagCounts;
+
+    void addTag(const QString& tag, quint32 handle);
+    void removeTag(const QString& tag, quint32 handle);
+
+    static QStringList tokenize(const QString& query);
+    TaskBitmap parseOr(const QStringList& tokens, int& pos, QString& error) const;
+    TaskBitmap parseAnd(const QStringList& tokens, int& pos, QString& error) const;
+    TaskBitmap parseNot(const QStringList& tokens, int& pos, QString& error) const;
+    TaskBitmap parseTerm(const QStringList& tokens, int& pos, QString& error) const;
+};
+
+#endif // TAGINDEX_H
@@ -1,52 +1,163 @@
 #include "task.h"
-#include <QUuid>
+#include "stringpool.h"
 
-Task::Task(const QString& t, const QString& d, const QDateTime& due, const QString& p, bool c, const QString& parent)
-    : title(t), description(d), dueDate(due), priority(p), completed(c),
-    createdDate(QDateTime::currentDateTime()), parentId(parent), level(0) {
-    id = QUuid::createUuid().toString(QUuid::WithoutBraces);
-}
+Task::Task(const QString& t, const QString& d, const QDateTime& due, const QString& p, bool c, const TaskId& parent)
+    : title(t), description(d), descriptionOffset(-1), descriptionSize(0), dueDate(due), priority(p), completed(c),
+    createdDate(QDateTime::currentDateTime()), parentId(parent), level(0) {}
 
 QJsonObject Task::toJson() const {
     QJsonObject obj;
-    obj["id"] = id;
+    obj["id"] = id.toString();
     obj["title"] = title;
-    obj["description"] = description;
+    if (hasStoredDescription()) {
+        obj["descriptionOffset"] = descriptionOffset;
+        obj["descriptionSize"] = descriptionSize;
+    } else if (!description.isEmpty()) {
+        obj["description"] = description;
+    }
     obj["dueDate"] = dueDate.toString(Qt::ISODate);
     obj["priority"] = priority;
     obj["completed"] = completed;
+    if (completedDate.isValid()) {
+        obj["completedDate"] = completedDate.toString(Qt::ISODate);
+    }
     obj["createdDate"] = createdDate.toString(Qt::ISODate);
-    obj["parentId"] = parentId;
+    obj["parentId"] = parentId.toString();
     obj["level"] = level;
 
     QJsonArray subtaskArray;
-    for (const QString& subtaskId : subtaskIds) {
-        subtaskArray.append(subtaskId);
+    for (const TaskId& subtaskId : subtaskIds) {
+        subtaskArray.append(subtaskId.toString());
     }
     obj["subtaskIds"] = subtaskArray;
 
+    if (!tags.isEmpty()) {
+        obj["tags"] = QJsonArray::fromStringList(tags);
+    }
+    if (!blockedBy.isEmpty()) {
+        QJsonArray blockedByArray;
+        for (const TaskId& blockerId : blockedBy) {
+            blockedByArray.append(blockerId.toString());
+        }
+        obj["blockedBy"] = blockedByArray;
+    }
+    if (recurrence.isRecurring()) {
+        obj["recurrence"] = recurrence.toJson();
+    }
+
     return obj;
 }
 
 Task Task::fromJson(const QJsonObject& obj) {
+    StringPool& pool = StringPool::shared();
     Task task;
-    task.id = obj["id"].toString();
+    task.id = TaskId::fromString(obj["id"].toString());
     task.title = obj["title"].toString();
     task.description = obj["description"].toString();
+    task.descriptionOffset = obj.contains("descriptionOffset") ? qint64(obj["descriptionOffset"].toDouble()) : -1;
+    task.descriptionSize = obj["descriptionSize"].toInt();
     task.dueDate = QDateTime::fromString(obj["dueDate"].toString(), Qt::ISODate);
-    task.priority = obj["priority"].toString();
+    task.priority = pool.intern(obj["priority"].toString());
     task.completed = obj["completed"].toBool();
+    task.completedDate = QDateTime::fromString(obj["completedDate"].toString(), Qt::ISODate);
+    if (task.completed && !task.completedDate.isValid()) {
+        // Older files did not record when a task was finished; start its archive age now
+        task.completedDate = QDateTime::currentDateTime();
+    }
     task.createdDate = QDateTime::fromString(obj["createdDate"].toString(), Qt::ISODate);
-    task.parentId = obj["parentId"].toString();
+    task.parentId = TaskId::fromString(obj["parentId"].toString());
     task.level = obj["level"].toInt();
 
     QJsonArray subtaskArray = obj["subtaskIds"].toArray();
     for (const QJsonValue& value : subtaskArray) {
-        task.subtaskIds.append(value.toString());
+        task.subtaskIds.append(TaskId::fromString(value.toString()));
+    }
+
+    // Normalized, so tag queries match files written elsewhere
+    QStringList tags;
+    for (const QJsonValue& value : obj["tags"].toArray()) {
+        tags.append(value.toString());
+    }
+    for (const QString& tag : normalizeTags(tags)) {
+        task.tags.append(pool.intern(tag));
+    }
+
+    QJsonArray blockedByArray = obj["blockedBy"].toArray();
+    for (const QJsonValue& value : blockedByArray) {
+        task.blockedBy.append(TaskId::fromString(value.toString()));
+    }
+
+    if (obj.contains("recurrence")) {
+        task.recurrence = Recurrence::fromJson(obj["recurrence"].toObject());
     }
 
     return task;
 }
 
-bool Task::isMainTask() const { return parentId.isEmpty(); }
+bool Task::isMainTask() const { return parentId.isNull(); }
 bool Task::hasSubtasks() const { return !subtaskIds.isEmpty(); }
+bool Task::hasStoredDescription() const { return descriptionOffset >= 0; }
+
+bool Task::isDueOn(const QDate& date) const {
+    if (dueDate.date() == date) return true;
+    return !completed && recurrence.isOpenOn(date);
+}
+
+void Task::setCompleted(bool c) {
+    if (completed == c) return;
+
+    if (recurrence.isRecurring()) {
+        if (c) {
+            // Finishing an occurrence moves the task on to the next one
+            recurrence.close(dueDate.date());
+            QDateTime next = recurrence.firstOpen();
+            if (next.isValid()) {
+                dueDate = next;
+                return;
+            }
+        } else {
+            recurrence.reopen(dueDate.date());
+        }
+    }
+
+    completed = c;
+    completedDate = c ? QDateTime::currentDateTime() : QDateTime();
+}
+
+QStringList Task::normalizeTags(const QStringList& tags)
+{
+    QStringList result;
+    for (const QString& part : tags) {
+        QString tag = part.trimmed().toLower().replace(' ', '-');
+        if (!tag.isEmpty() && !result.contains(tag)) {
+            result.append(tag);
+        }
+    }
+    return result;
+}
+
+QStringList Task::parseTags(const QString& text)
+{
+    return normalizeTags(text.split(','));
+}
+
+QDataStream& operator<<(QDataStream& out, const Task& task) {
+    out << task.id << task.title << task.description << task.descriptionOffset << task.descriptionSize
+        << task.dueDate << task.priority << task.completed << task.completedDate << task.createdDate
+        << task.parentId << qint32(task.level) << task.tags << task.blockedBy << task.recurrence;
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, Task& task) {
+    qint32 level = 0;
+    in >> task.id >> task.title >> task.description >> task.descriptionOffset >> task.descriptionSize
+       >> task.dueDate >> task.priority >> task.completed >> task.completedDate >> task.createdDate
+       >> task.parentId >> level >> task.tags >> task.blockedBy >> task.recurrence;
+    task.level = level;
+    task.subtaskIds.clear();
+
+    StringPool& pool = StringPool::shared();
+    task.priority = pool.intern(task.priority);
+    pool.intern(task.tags);
+    return in;
+}
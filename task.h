@@ -1,31 +1,53 @@
 #ifndef TASK_H
 #define TASK_H
 #include <QString>
+#include <QStringList>
 #include <QDateTime>
 #include <QJsonObject>
 #include <QJsonArray>
+#include "taskid.h"
+#include "recurrence.h"
 
 class Task
 {
 public:
-    QString id;
+    TaskId id; // Null until the task is inserted into a tree or store
     QString title;
-    QString description;
+    QString description; // Inline text, only until it is written to the DescriptionStore
+    qint64 descriptionOffset; // Location in the DescriptionStore, -1 if none
+    qint32 descriptionSize;
     QDateTime dueDate;
     QString priority;
     bool completed;
+    QDateTime completedDate;
     QDateTime createdDate;
-    QString parentId;
-    QList<QString> subtaskIds;
+    TaskId parentId;
+    QList<TaskId> subtaskIds;
     int level; // Depth level for display
+    QStringList tags;
+    QList<TaskId> blockedBy; // Ids of tasks that must be completed first
+    Recurrence recurrence; // When set, dueDate is the earliest open occurrence
 
     Task(const QString& t = "", const QString& d = "", const QDateTime& due = QDateTime::currentDateTime(),
-         const QString& p = "Medium", bool c = false, const QString& parent = "");
+         const QString& p = "Medium", bool c = false, const TaskId& parent = TaskId());
 
     QJsonObject toJson() const;
     static Task fromJson(const QJsonObject& obj);
     bool isMainTask() const;
     bool hasSubtasks() const;
+    bool hasStoredDescription() const;
+    bool isDueOn(const QDate& date) const;
+    void setCompleted(bool c);
+
+    // Tags in the one form the board keeps: trimmed, lowercase, spaces as hyphens,
+    // no empty or repeated ones
+    static QStringList normalizeTags(const QStringList& tags);
+    static QStringList parseTags(const QString& text); // Comma-separated
 };
 
+// Compact binary form for messages between instances. Subtask lists are not
+// written: a receiver rebuilds them from parentId.
+QDataStream& operator<<(QDataStream& out, const Task& task);
+QDataStream& operator>>(QDataStream& in, Task& task);
+
 #endif // TASK_H
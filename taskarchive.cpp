@@ -0,0 +1,150 @@
+#include "taskarchive.h"
+#include <QFile>
+#include <QDataStream>
+#include <QJsonDocument>
+#include <QJsonArray>
+
+bool TaskArchive::open(const QString& path)
+{
+    filePath = path;
+    index.clear();
+    order.clear();
+
+    QFile file(filePath);
+    if (!file.exists()) return true;
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    // Rebuild the index from the record headers, skipping over the payloads
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+    while (!in.atEnd()) {
+        qint64 offset = file.pos();
+        quint8 type = 0;
+        QString rootText; // Ids are kept in their text form on disk
+        in >> type >> rootText;
+        TaskId rootId = TaskId::fromString(rootText);
+
+        if (type == SubtreeRecord) {
+            Entry entry;
+            quint32 payloadSize = 0;
+            entry.rootId = rootId;
+            entry.offset = offset;
+            in >> entry.title >> entry.completedDate >> entry.taskCount >> payloadSize;
+            in.skipRawData(payloadSize);
+            if (in.status() != QDataStream::Ok) break; // Truncated tail record
+
+            index.insert(rootId, entry);
+            order.removeOne(rootId);
+            order.append(rootId);
+        } else if (type == RestoredRecord) {
+            if (in.status() != QDataStream::Ok) break;
+            index.remove(rootId);
+            order.removeOne(rootId);
+        } else {
+            break;
+        }
+    }
+    return true;
+}
+
+bool TaskArchive::append(const QList<Task>& subtree)
+{
+    if (subtree.isEmpty()) return false;
+
+    Entry entry;
+    entry.rootId = subtree.first().id;
+    entry.title = subtree.first().title;
+    entry.taskCount = subtree.size();
+
+    QJsonArray jsonArray;
+    for (const Task& task : subtree) {
+        jsonArray.append(task.toJson());
+        if (task.completedDate > entry.completedDate) {
+            entry.completedDate = task.completedDate;
+        }
+    }
+    QByteArray payload = qCompress(QJsonDocument(jsonArray).toJson(QJsonDocument::Compact));
+
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << quint8(SubtreeRecord) << entry.rootId.toString() << entry.title << entry.completedDate
+        << entry.taskCount << quint32(payload.size());
+    out.writeRawData(payload.constData(), payload.size());
+
+    if (!writeRecord(record, &entry.offset)) return false;
+
+    index.insert(entry.rootId, entry);
+    order.removeOne(entry.rootId);
+    order.append(entry.rootId);
+    return true;
+}
+
+QList<TaskArchive::Entry> TaskArchive::entries() const
+{
+    QList<Entry> result;
+    for (const TaskId& rootId : order) {
+        result.append(index.value(rootId));
+    }
+    return result;
+}
+
+bool TaskArchive::contains(const TaskId& rootId) const
+{
+    return index.contains(rootId);
+}
+
+QList<Task> TaskArchive::load(const TaskId& rootId) const
+{
+    QList<Task> tasks;
+    if (!index.contains(rootId)) return tasks;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(index[rootId].offset)) return tasks;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+    quint8 type = 0;
+    QString id, title;
+    QDateTime completedDate;
+    int taskCount = 0;
+    quint32 payloadSize = 0;
+    in >> type >> id >> title >> completedDate >> taskCount >> payloadSize;
+    if (in.status() != QDataStream::Ok || type != SubtreeRecord || TaskId::fromString(id) != rootId) return tasks;
+
+    QByteArray payload(int(payloadSize), Qt::Uninitialized);
+    if (in.readRawData(payload.data(), int(payloadSize)) != int(payloadSize)) return tasks;
+
+    QJsonArray jsonArray = QJsonDocument::fromJson(qUncompress(payload)).array();
+    for (const QJsonValue& value : jsonArray) {
+        tasks.append(Task::fromJson(value.toObject()));
+    }
+    return tasks;
+}
+
+bool TaskArchive::retire(const TaskId& rootId)
+{
+    if (!index.contains(rootId)) return true;
+
+    // The file is append-only; a marker record retires the archived copy
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << quint8(RestoredRecord) << rootId.toString();
+
+    qint64 offset = -1;
+    if (!writeRecord(record, &offset)) return false;
+
+    index.remove(rootId);
+    order.removeOne(rootId);
+    return true;
+}
+
+bool TaskArchive::writeRecord(const QByteArray& record, qint64* offset)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) return false;
+
+    *offset = file.size();
+    return file.write(record) == record.size();
+}
@@ -0,0 +1,40 @@
+#ifndef TASKARCHIVE_H
+#define TASKARCHIVE_H
+#include <QString>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include "task.h"
+
+// Append-only cold storage for finished task subtrees. Each record holds a small
+// uncompressed header (used to index the file) and a qCompress'ed JSON payload
+// that is only read back when the subtree is queried or restored.
+class TaskArchive
+{
+public:
+    struct Entry {
+        TaskId rootId;
+        QString title;
+        QDateTime completedDate;
+        int taskCount = 0;
+        qint64 offset = -1;
+    };
+
+    bool open(const QString& path);
+    bool append(const QList<Task>& subtree);
+    QList<Entry> entries() const;
+    bool contains(const TaskId& rootId) const;
+    QList<Task> load(const TaskId& rootId) const;
+    bool retire(const TaskId& rootId);
+
+private:
+    enum RecordType : quint8 { SubtreeRecord = 1, RestoredRecord = 2 };
+
+    QString filePath;
+    QHash<TaskId, Entry> index;
+    QList<TaskId> order;
+
+    bool writeRecord(const QByteArray& record, qint64* offset);
+};
+
+#endif // TASKARCHIVE_H
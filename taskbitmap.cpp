@@ -0,0 +1,122 @@
+#include "taskbitmap.h"
+
+void TaskBitmap::set(quint32 handle)
+{
+    Chunk& chunk = chunks[handle >> ChunkShift];
+    if (chunk.empty()) {
+        chunk.assign(WordsPerChunk, 0);
+    }
+    quint32 offset = handle & ((1u << ChunkShift) - 1);
+    chunk[offset / 64] |= quint64(1) << (offset % 64);
+}
+
+void TaskBitmap::reset(quint32 handle)
+{
+    auto it = chunks.find(handle >> ChunkShift);
+    if (it == chunks.end()) return;
+
+    quint32 offset = handle & ((1u << ChunkShift) - 1);
+    it->second[offset / 64] &= ~(quint64(1) << (offset % 64));
+}
+
+bool TaskBitmap::test(quint32 handle) const
+{
+    auto it = chunks.find(handle >> ChunkShift);
+    if (it == chunks.end()) return false;
+
+    quint32 offset = handle & ((1u << ChunkShift) - 1);
+    return it->second[offset / 64] & (quint64(1) << (offset % 64));
+}
+
+int TaskBitmap::count() const
+{
+    int total = 0;
+    for (const auto& chunk : chunks) {
+        for (quint64 word : chunk.second) {
+            total += qPopulationCount(word);
+        }
+    }
+    return total;
+}
+
+bool TaskBitmap::isEmpty() const
+{
+    for (const auto& chunk : chunks) {
+        if (!isZero(chunk.second)) return false;
+    }
+    return true;
+}
+
+TaskBitmap TaskBitmap::operator&(const TaskBitmap& other) const
+{
+    TaskBitmap result;
+    auto a = chunks.begin();
+    auto b = other.chunks.begin();
+    while (a != chunks.end() && b != other.chunks.end()) {
+        if (a->first < b->first) {
+            ++a;
+        } else if (b->first < a->first) {
+            ++b;
+        } else {
+            Chunk words(WordsPerChunk);
+            quint64 any = 0;
+            for (int i = 0; i < WordsPerChunk; ++i) {
+                words[i] = a->second[i] & b->second[i];
+                any |= words[i];
+            }
+            if (any) {
+                result.chunks.emplace(a->first, std::move(words));
+            }
+            ++a;
+            ++b;
+        }
+    }
+    return result;
+}
+
+TaskBitmap TaskBitmap::operator|(const TaskBitmap& other) const
+{
+    TaskBitmap result = *this;
+    for (const auto& chunk : other.chunks) {
+        Chunk& words = result.chunks[chunk.first];
+        if (words.empty()) {
+            words = chunk.second;
+            continue;
+        }
+        for (int i = 0; i < WordsPerChunk; ++i) {
+            words[i] |= chunk.second[i];
+        }
+    }
+    return result;
+}
+
+TaskBitmap TaskBitmap::andNot(const TaskBitmap& other) const
+{
+    TaskBitmap result;
+    for (const auto& chunk : chunks) {
+        auto match = other.chunks.find(chunk.first);
+        if (match == other.chunks.end()) {
+            result.chunks.emplace(chunk.first, chunk.second);
+            continue;
+        }
+
+        Chunk words(WordsPerChunk);
+        quint64 any = 0;
+        for (int i = 0; i < WordsPerChunk; ++i) {
+            words[i] = chunk.second[i] & ~match->second[i];
+            any |= words[i];
+        }
+        if (any) {
+            result.chunks.emplace(chunk.first, std::move(words));
+        }
+    }
+    return result;
+}
+
+bool TaskBitmap::isZero(const Chunk& chunk)
+{
+    for (quint64 word : chunk) {
+        if (word) return false;
+    }
+    return true;
+}
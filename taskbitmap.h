@@ -0,0 +1,50 @@
+#ifndef TASKBITMAP_H
+#define TASKBITMAP_H
+#include <QtGlobal>
+#include <QtAlgorithms>
+#include <map>
+#include <vector>
+
+// Set of task handles stored as 64K-bit chunks, with empty chunks left out.
+// Set algebra works a 64-bit word at a time and only on chunks present in
+// the operands.
+class TaskBitmap
+{
+public:
+    void set(quint32 handle);
+    void reset(quint32 handle);
+    bool test(quint32 handle) const;
+    int count() const;
+    bool isEmpty() const;
+
+    TaskBitmap operator&(const TaskBitmap& other) const;
+    TaskBitmap operator|(const TaskBitmap& other) const;
+    TaskBitmap andNot(const TaskBitmap& other) const;
+
+    template<typename Function>
+    void forEach(Function function) const
+    {
+        for (const auto& chunk : chunks) {
+            quint32 base = chunk.first << ChunkShift;
+            for (int word = 0; word < WordsPerChunk; ++word) {
+                quint64 bits = chunk.second[word];
+                while (bits) {
+                    int bit = qCountTrailingZeroBits(bits);
+                    function(base + quint32(word * 64 + bit));
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+
+private:
+    static const int ChunkShift = 16;
+    static const int WordsPerChunk = (1 << ChunkShift) / 64;
+
+    using Chunk = std::vector<quint64>;
+    std::map<quint32, Chunk> chunks;
+
+    static bool isZero(const Chunk& chunk);
+};
+
+#endif // TASKBITMAP_H
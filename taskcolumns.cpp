@@ -0,0 +1,464 @@
+#include "taskcolumns.h"
+#include <QtAlgorithms>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define TASKCOLUMNS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define TASKCOLUMNS_AVX2
+#else
+#define TASKCOLUMNS_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+const size_t RowsPerWord = 64;
+const qint64 NoTime = std::numeric_limits<qint64>::max();
+
+// Each kernel writes one output word per 64 rows; bit i is row i of that block
+
+void bytesEqualScalar(const quint8* column, size_t wordCount, quint8 value, quint64* out)
+{
+    for (size_t word = 0; word < wordCount; ++word) {
+        const quint8* rows = column + word * RowsPerWord;
+        quint64 bits = 0;
+        for (size_t i = 0; i < RowsPerWord; ++i) {
+            bits |= quint64(rows[i] == value) << i;
+        }
+        out[word] = bits;
+    }
+}
+
+void bytesAtMostScalar(const quint8* column, size_t wordCount, quint8 value, quint64* out)
+{
+    for (size_t word = 0; word < wordCount; ++word) {
+        const quint8* rows = column + word * RowsPerWord;
+        quint64 bits = 0;
+        for (size_t i = 0; i < RowsPerWord; ++i) {
+            bits |= quint64(rows[i] <= value) << i;
+        }
+        out[word] = bits;
+    }
+}
+
+void timesBetweenScalar(const qint64* column, size_t wordCount, qint64 from, qint64 to, quint64* out)
+{
+    for (size_t word = 0; word < wordCount; ++word) {
+        const qint64* rows = column + word * RowsPerWord;
+        quint64 bits = 0;
+        for (size_t i = 0; i < RowsPerWord; ++i) {
+            bits |= quint64(rows[i] >= from && rows[i] < to) << i;
+        }
+        out[word] = bits;
+    }
+}
+
+#ifdef TASKCOLUMNS_X86
+
+void bytesEqualSse2(const quint8* column, size_t wordCount, quint8 value, quint64* out)
+{
+    const __m128i needle = _mm_set1_epi8(char(value));
+    for (size_t word = 0; word < wordCount; ++word) {
+        const quint8* rows = column + word * RowsPerWord;
+        quint64 bits = 0;
+        for (int i = 0; i < 4; ++i) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows + i * 16));
+            quint32 mask = quint32(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+            bits |= quint64(mask) << (i * 16);
+        }
+        out[word] = bits;
+    }
+}
+
+void bytesAtMostSse2(const quint8* column, size_t wordCount, quint8 value, quint64* out)
+{
+    // Unsigned x <= v exactly when min(x, v) == x
+    const __m128i limit = _mm_set1_epi8(char(value));
+    for (size_t word = 0; word < wordCount; ++word) {
+        const quint8* rows = column + word * RowsPerWord;
+        quint64 bits = 0;
+        for (int i = 0; i < 4; ++i) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows + i * 16));
+            quint32 mask = quint32(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(chunk, limit), chunk)));
+            bits |= quint64(mask) << (i * 16);
+        }
+        out[word] = bits;
+    }
+}
+
+TASKCOLUMNS_AVX2
+void bytesEqualAvx2(const quint8* column, size_t wordCount, quint8 value, quint64* out)
+{
+    const __m256i needle = _mm256_set1_epi8(char(value));
+    for (size_t word = 0; word < wordCount; ++word) {
+        const quint8* rows = column + word * RowsPerWord;
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows + 32));
+        quint32 lowMask = quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, needle)));
+        quint32 highMask = quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, needle)));
+        out[word] = quint64(lowMask) | (quint64(highMask) << 32);
+    }
+}
+
+TASKCOLUMNS_AVX2
+void bytesAtMostAvx2(const quint8* column, size_t wordCount, quint8 value, quint64* out)
+{
+    const __m256i limit = _mm256_set1_epi8(char(value));
+    for (size_t word = 0; word < wordCount; ++word) {
+        const quint8* rows = column + word * RowsPerWord;
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows + 32));
+        quint32 lowMask = quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(low, limit), low)));
+        quint32 highMask = quint32(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(high, limit), high)));
+        out[word] = quint64(lowMask) | (quint64(highMask) << 32);
+    }
+}
+
+TASKCOLUMNS_AVX2
+void timesBetweenAvx2(const qint64* column, size_t wordCount, qint64 from, qint64 to, quint64* out)
+{
+    const __m256i lower = _mm256_set1_epi64x(from);
+    const __m256i upper = _mm256_set1_epi64x(to);
+    for (size_t word = 0; word < wordCount; ++word) {
+        const qint64* rows = column + word * RowsPerWord;
+        quint64 bits = 0;
+        for (int i = 0; i < 16; ++i) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows + i * 4));
+            // from <= x is !(from > x); x < to is to > x
+            __m256i inRange = _mm256_andnot_si256(_mm256_cmpgt_epi64(lower, chunk), _mm256_cmpgt_epi64(upper, chunk));
+            bits |= quint64(_mm256_movemask_pd(_mm256_castsi256_pd(inRange))) << (i * 4);
+        }
+        out[word] = bits;
+    }
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && (info[1] & (1 << 5));
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // TASKCOLUMNS_X86
+
+}
+
+TaskColumns::Selection& TaskColumns::Selection::operator&=(const Selection& other)
+{
+    if (words.size() > other.words.size()) {
+        words.resize(other.words.size());
+    }
+    for (size_t i = 0; i < words.size(); ++i) {
+        words[i] &= other.words[i];
+    }
+    return *this;
+}
+
+TaskColumns::Selection& TaskColumns::Selection::operator|=(const Selection& other)
+{
+    if (words.size() < other.words.size()) {
+        words.resize(other.words.size(), 0);
+    }
+    for (size_t i = 0; i < other.words.size(); ++i) {
+        words[i] |= other.words[i];
+    }
+    return *this;
+}
+
+TaskColumns::Selection TaskColumns::Selection::operator&(const Selection& other) const
+{
+    Selection result = *this;
+    result &= other;
+    return result;
+}
+
+TaskColumns::Selection TaskColumns::Selection::operator|(const Selection& other) const
+{
+    Selection result = *this;
+    result |= other;
+    return result;
+}
+
+TaskColumns::Selection TaskColumns::Selection::andNot(const Selection& other) const
+{
+    Selection result = *this;
+    size_t shared = qMin(result.words.size(), other.words.size());
+    for (size_t i = 0; i < shared; ++i) {
+        result.words[i] &= ~other.words[i];
+    }
+    return result;
+}
+
+bool TaskColumns::Selection::test(quint32 row) const
+{
+    size_t word = row / RowsPerWord;
+    return word < words.size() && (words[word] >> (row % RowsPerWord)) & 1;
+}
+
+int TaskColumns::Selection::count() const
+{
+    int total = 0;
+    for (quint64 bits : words) {
+        total += qPopulationCount(bits);
+    }
+    return total;
+}
+
+TaskColumns::TaskColumns()
+    : activeIsa(bestIsa()) {}
+
+void TaskColumns::clear()
+{
+    handles.clear();
+    idsByHandle.clear();
+    freeHandles.clear();
+    liveWords.clear();
+    completedWords.clear();
+    priorities.clear();
+    depths.clear();
+    dueTimes.clear();
+    createdTimes.clear();
+}
+
+void TaskColumns::addTask(const Task& task)
+{
+    auto it = handles.constFind(task.id);
+    quint32 row = it != handles.constEnd() ? it.value() : allocateRow();
+    handles.insert(task.id, row);
+    idsByHandle[row] = task.id;
+    writeRow(row, task);
+}
+
+void TaskColumns::updateTask(const Task& task)
+{
+    addTask(task);
+}
+
+void TaskColumns::removeTask(const TaskId& taskId)
+{
+    auto it = handles.find(taskId);
+    if (it == handles.end()) return;
+
+    quint32 row = it.value();
+    handles.erase(it);
+    idsByHandle[row] = TaskId();
+    liveWords[row / RowsPerWord] &= ~(quint64(1) << (row % RowsPerWord));
+    completedWords[row / RowsPerWord] &= ~(quint64(1) << (row % RowsPerWord));
+    freeHandles.push_back(row);
+}
+
+int TaskColumns::size() const
+{
+    return handles.size();
+}
+
+TaskColumns::Isa TaskColumns::bestIsa()
+{
+#ifdef TASKCOLUMNS_X86
+    static const Isa best = cpuHasAvx2() ? Avx2 : Sse2;
+    return best;
+#else
+    return Scalar;
+#endif
+}
+
+TaskColumns::Isa TaskColumns::isa() const
+{
+    return activeIsa;
+}
+
+void TaskColumns::setIsa(Isa isa)
+{
+    activeIsa = qMin(isa, bestIsa());
+}
+
+TaskColumns::Selection TaskColumns::all() const
+{
+    Selection result;
+    result.words = liveWords;
+    return result;
+}
+
+TaskColumns::Selection TaskColumns::completed() const
+{
+    Selection result;
+    result.words = completedWords;
+    return result;
+}
+
+TaskColumns::Selection TaskColumns::pending() const
+{
+    return all().andNot(completed());
+}
+
+TaskColumns::Selection TaskColumns::priorityEquals(const QString& priority) const
+{
+    return bytesEqual(priorities, priorityCode(priority));
+}
+
+TaskColumns::Selection TaskColumns::depthAtMost(int depth) const
+{
+    if (depth < 0) return Selection();
+    return bytesAtMost(depths, quint8(qMin(depth, 255)));
+}
+
+TaskColumns::Selection TaskColumns::dueBetween(const QDateTime& from, const QDateTime& to) const
+{
+    return timesBetween(dueTimes, from, to);
+}
+
+TaskColumns::Selection TaskColumns::createdBetween(const QDateTime& from, const QDateTime& to) const
+{
+    return timesBetween(createdTimes, from, to);
+}
+
+bool TaskColumns::contains(const Selection& selection, const TaskId& taskId) const
+{
+    auto it = handles.constFind(taskId);
+    return it != handles.constEnd() && selection.test(it.value());
+}
+
+QList<TaskId> TaskColumns::taskIds(const Selection& selection) const
+{
+    QList<TaskId> ids;
+    for (size_t word = 0; word < selection.words.size(); ++word) {
+        quint64 bits = selection.words[word];
+        while (bits) {
+            size_t row = word * RowsPerWord + size_t(qCountTrailingZeroBits(bits));
+            if (row < idsByHandle.size() && !idsByHandle[row].isNull()) {
+                ids.append(idsByHandle[row]);
+            }
+            bits &= bits - 1;
+        }
+    }
+    return ids;
+}
+
+quint32 TaskColumns::allocateRow()
+{
+    if (!freeHandles.empty()) {
+        quint32 row = freeHandles.back();
+        freeHandles.pop_back();
+        return row;
+    }
+
+    quint32 row = quint32(idsByHandle.size());
+    idsByHandle.push_back(TaskId());
+    if (row / RowsPerWord >= liveWords.size()) {
+        // Grow every column by one whole word of rows
+        liveWords.push_back(0);
+        completedWords.push_back(0);
+        priorities.resize(priorities.size() + RowsPerWord, 0);
+        depths.resize(depths.size() + RowsPerWord, 0);
+        dueTimes.resize(dueTimes.size() + RowsPerWord, NoTime);
+        createdTimes.resize(createdTimes.size() + RowsPerWord, NoTime);
+    }
+    return row;
+}
+
+void TaskColumns::writeRow(quint32 row, const Task& task)
+{
+    quint64 bit = quint64(1) << (row % RowsPerWord);
+    liveWords[row / RowsPerWord] |= bit;
+    if (task.completed) {
+        completedWords[row / RowsPerWord] |= bit;
+    } else {
+        completedWords[row / RowsPerWord] &= ~bit;
+    }
+    priorities[row] = priorityCode(task.priority);
+    depths[row] = quint8(qBound(0, task.level, 255));
+    dueTimes[row] = timeKey(task.dueDate);
+    createdTimes[row] = timeKey(task.createdDate);
+}
+
+TaskColumns::Selection TaskColumns::fromWords(std::vector<quint64> words) const
+{
+    // Padding and freed rows hold stale values; only live rows may match
+    for (size_t i = 0; i < words.size(); ++i) {
+        words[i] &= liveWords[i];
+    }
+    Selection result;
+    result.words = std::move(words);
+    return result;
+}
+
+TaskColumns::Selection TaskColumns::bytesEqual(const std::vector<quint8>& column, quint8 value) const
+{
+    std::vector<quint64> words(liveWords.size());
+    switch (activeIsa) {
+#ifdef TASKCOLUMNS_X86
+    case Avx2:
+        bytesEqualAvx2(column.data(), words.size(), value, words.data());
+        break;
+    case Sse2:
+        bytesEqualSse2(column.data(), words.size(), value, words.data());
+        break;
+#endif
+    default:
+        bytesEqualScalar(column.data(), words.size(), value, words.data());
+        break;
+    }
+    return fromWords(std::move(words));
+}
+
+TaskColumns::Selection TaskColumns::bytesAtMost(const std::vector<quint8>& column, quint8 value) const
+{
+    std::vector<quint64> words(liveWords.size());
+    switch (activeIsa) {
+#ifdef TASKCOLUMNS_X86
+    case Avx2:
+        bytesAtMostAvx2(column.data(), words.size(), value, words.data());
+        break;
+    case Sse2:
+        bytesAtMostSse2(column.data(), words.size(), value, words.data());
+        break;
+#endif
+    default:
+        bytesAtMostScalar(column.data(), words.size(), value, words.data());
+        break;
+    }
+    return fromWords(std::move(words));
+}
+
+TaskColumns::Selection TaskColumns::timesBetween(const std::vector<qint64>& column, const QDateTime& from,
+                                                 const QDateTime& to) const
+{
+    std::vector<quint64> words(liveWords.size());
+    qint64 lower = from.isValid() ? from.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min();
+    qint64 upper = to.isValid() ? to.toMSecsSinceEpoch() : NoTime;
+    switch (activeIsa) {
+#ifdef TASKCOLUMNS_X86
+    case Avx2:
+        timesBetweenAvx2(column.data(), words.size(), lower, upper, words.data());
+        break;
+#endif
+    default:
+        // SSE2 has no 64-bit compare; the scalar loop is what it would do anyway
+        timesBetweenScalar(column.data(), words.size(), lower, upper, words.data());
+        break;
+    }
+    return fromWords(std::move(words));
+}
+
+quint8 TaskColumns::priorityCode(const QString& priority)
+{
+    if (priority == "Low") return 0;
+    if (priority == "Medium") return 1;
+    if (priority == "High") return 2;
+    return 3;
+}
+
+qint64 TaskColumns::timeKey(const QDateTime& dateTime)
+{
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : NoTime;
+}
@@ -0,0 +1,83 @@
+#ifndef TASKCOLUMNS_H
+#define TASKCOLUMNS_H
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <vector>
+#include "task.h"
+
+// The fields bulk filters test, packed one array per field and indexed by a
+// dense row handle: a completed bitset, priority and depth bytes, and due and
+// created times as milliseconds. Predicates run over a whole column at once with
+// SSE2 or AVX2 kernels (picked at run time, with a scalar fallback) and return a
+// Selection with one bit per row, so combining them is plain word-wise logic.
+class TaskColumns
+{
+public:
+    enum Isa { Scalar, Sse2, Avx2 };
+
+    class Selection
+    {
+    public:
+        Selection& operator&=(const Selection& other);
+        Selection& operator|=(const Selection& other);
+        Selection operator&(const Selection& other) const;
+        Selection operator|(const Selection& other) const;
+        Selection andNot(const Selection& other) const;
+        bool test(quint32 row) const;
+        int count() const;
+
+    private:
+        friend class TaskColumns;
+        std::vector<quint64> words;
+    };
+
+    TaskColumns();
+
+    void clear();
+    void addTask(const Task& task);
+    void updateTask(const Task& task);
+    void removeTask(const TaskId& taskId);
+    int size() const;
+
+    static Isa bestIsa();
+    Isa isa() const;
+    void setIsa(Isa isa); // Clamped to what this CPU supports
+
+    Selection all() const;
+    Selection completed() const;
+    Selection pending() const;
+    Selection priorityEquals(const QString& priority) const;
+    Selection depthAtMost(int depth) const;
+    Selection dueBetween(const QDateTime& from, const QDateTime& to) const;
+    Selection createdBetween(const QDateTime& from, const QDateTime& to) const;
+
+    bool contains(const Selection& selection, const TaskId& taskId) const;
+    QList<TaskId> taskIds(const Selection& selection) const;
+
+private:
+    QHash<TaskId, quint32> handles;
+    std::vector<TaskId> idsByHandle;
+    std::vector<quint32> freeHandles;
+
+    // Sized in whole 64-row words so kernels never handle a partial word
+    std::vector<quint64> liveWords;
+    std::vector<quint64> completedWords;
+    std::vector<quint8> priorities;
+    std::vector<quint8> depths;
+    std::vector<qint64> dueTimes;
+    std::vector<qint64> createdTimes;
+    Isa activeIsa;
+
+    quint32 allocateRow();
+    void writeRow(quint32 row, const Task& task);
+    Selection fromWords(std::vector<quint64> words) const;
+    Selection bytesEqual(const std::vector<quint8>& column, quint8 value) const;
+    Selection bytesAtMost(const std::vector<quint8>& column, quint8 value) const;
+    Selection timesBetween(const std::vector<qint64>& column, const QDateTime& from, const QDateTime& to) const;
+
+    static quint8 priorityCode(const QString& priority);
+    static qint64 timeKey(const QDateTime& dateTime);
+};
+
+#endif // TASKCOLUMNS_H
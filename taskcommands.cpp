@@ -0,0 +1,243 @@
+#include "taskcommands.h"
+#include "tasktreewidget.h"
+#include <QDataStream>
+#include <algorithm>
+
+namespace {
+
+struct Position {
+    TaskId taskId;
+    TaskId parentId;
+    qint32 index;
+};
+
+QDataStream& operator<<(QDataStream& out, const Position& position)
+{
+    return out << position.taskId << position.parentId << position.index;
+}
+
+QDataStream& operator>>(QDataStream& in, Position& position)
+{
+    return in >> position.taskId >> position.parentId >> position.index;
+}
+
+bool contains(const TaskTreeWidget* tree, const TaskId& taskId)
+{
+    return tree->getStore().contains(taskId);
+}
+
+QList<TaskId> rootsOf(const QList<Task>& tasks)
+{
+    QSet<TaskId> ids;
+    for (const Task& task : tasks) {
+        ids.insert(task.id);
+    }
+    QList<TaskId> roots;
+    for (const Task& task : tasks) {
+        if (!ids.contains(task.parentId)) {
+            roots.append(task.id);
+        }
+    }
+    return roots;
+}
+
+// Tasks ready for addTasks(): ones already back in the tree are dropped, and a
+// subtree whose parent has gone since becomes a main task
+QList<Task> attachable(const TaskTreeWidget* tree, const QList<Task>& tasks)
+{
+    QList<Task> result;
+    QHash<TaskId, int> levelShifts;
+    for (Task task : tasks) {
+        if (contains(tree, task.id)) continue;
+
+        int shift = 0;
+        if (levelShifts.contains(task.parentId)) {
+            shift = levelShifts[task.parentId];
+        } else if (!task.parentId.isNull() && !contains(tree, task.parentId)) {
+            shift = task.level;
+            task.parentId = TaskId();
+        }
+        task.level -= shift;
+        levelShifts.insert(task.id, shift);
+        result.append(task);
+    }
+    return result;
+}
+
+} // namespace
+
+TaskCommand::TaskCommand(TaskTreeWidget* tree, const QString& text)
+    : tree(tree)
+{
+    setText(text);
+}
+
+AddTasksCommand::AddTasksCommand(TaskTreeWidget* tree, const QList<Task>& tasks, const QString& text)
+    : TaskCommand(tree, text), rootIds(rootsOf(tasks))
+{
+    QDataStream out(&records, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << tasks;
+}
+
+void AddTasksCommand::redo()
+{
+    QList<Task> tasks;
+    QDataStream in(records);
+    in.setVersion(QDataStream::Qt_5_15);
+    in >> tasks;
+    tree->addTasks(attachable(tree, tasks));
+}
+
+void AddTasksCommand::undo()
+{
+    tree->removeTasks(rootIds);
+}
+
+qint64 AddTasksCommand::byteSize() const
+{
+    return sizeof(*this) + records.size() + rootIds.size() * sizeof(TaskId);
+}
+
+RemoveTasksCommand::RemoveTasksCommand(TaskTreeWidget* tree, const QList<TaskId>& taskIds, const QString& text)
+    : TaskCommand(tree, text)
+{
+    // A task whose ancestor is also listed goes with that ancestor's subtree
+    QSet<TaskId> listed(taskIds.begin(), taskIds.end());
+    for (const TaskId& taskId : taskIds) {
+        if (!contains(tree, taskId) || rootIds.contains(taskId)) continue;
+        bool underListed = false;
+        for (TaskId id = tree->getTaskById(taskId).parentId; !id.isNull(); id = tree->getTaskById(id).parentId) {
+            if (listed.contains(id)) {
+                underListed = true;
+                break;
+            }
+        }
+        if (!underListed) {
+            rootIds.append(taskId);
+        }
+    }
+
+    QList<Task> tasks;
+    QList<Position> positions;
+    for (const TaskId& rootId : rootIds) {
+        tasks.append(tree->getSubtree(rootId));
+        positions.append({rootId, tree->getTaskById(rootId).parentId, qint32(tree->getTaskIndex(rootId))});
+    }
+    std::sort(positions.begin(), positions.end(), [](const Position& a, const Position& b) {
+        return a.index < b.index;
+    });
+
+    // Blockers the removal strips from tasks that stay behind
+    QSet<TaskId> removed;
+    for (const Task& task : tasks) {
+        removed.insert(task.id);
+    }
+    QList<QPair<TaskId, TaskId>> edges;
+    for (const Task& task : tasks) {
+        for (const TaskId& dependentId : tree->getDependencies().dependents(task.id)) {
+            if (!removed.contains(dependentId)) {
+                edges.append({dependentId, task.id});
+            }
+        }
+    }
+
+    QDataStream out(&records, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << tasks << positions << edges;
+}
+
+void RemoveTasksCommand::redo()
+{
+    tree->removeTasks(rootIds);
+}
+
+void RemoveTasksCommand::undo()
+{
+    QList<Task> tasks;
+    QList<Position> positions;
+    QList<QPair<TaskId, TaskId>> edges;
+    QDataStream in(records);
+    in.setVersion(QDataStream::Qt_5_15);
+    in >> tasks >> positions >> edges;
+
+    // One batch, so the view is refiltered once rather than after every move and edge
+    tree->beginBatch();
+    tree->addTasks(attachable(tree, tasks));
+
+    // Ascending indexes, so each insert lands among the siblings that preceded it
+    for (const Position& position : positions) {
+        const Task* task = tree->getStore().find(position.taskId);
+        if (task && task->parentId == position.parentId && tree->getTaskIndex(position.taskId) != position.index) {
+            tree->moveTask(position.taskId, position.parentId, position.index);
+        }
+    }
+    for (const auto& edge : edges) {
+        tree->addDependency(edge.first, edge.second);
+    }
+    tree->endBatch();
+}
+
+qint64 RemoveTasksCommand::byteSize() const
+{
+    return sizeof(*this) + records.size() + rootIds.size() * sizeof(TaskId);
+}
+
+EditTaskCommand::EditTaskCommand(TaskTreeWidget* tree, const TaskId& taskId, const TaskDelta& delta,
+                                 const QString& text)
+    : TaskCommand(tree, text), taskId(taskId), delta(delta)
+{
+}
+
+void EditTaskCommand::redo()
+{
+    const Task* current = tree->getStore().find(taskId);
+    if (!current) return;
+    Task task = *current;
+    delta.applyAfter(task);
+    tree->updateTask(taskId, task);
+}
+
+void EditTaskCommand::undo()
+{
+    const Task* current = tree->getStore().find(taskId);
+    if (!current) return;
+    Task task = *current;
+    delta.applyBefore(task);
+    tree->updateTask(taskId, task);
+}
+
+qint64 EditTaskCommand::byteSize() const
+{
+    return sizeof(*this) + delta.byteSize();
+}
+
+DependencyCommand::DependencyCommand(TaskTreeWidget* tree, const TaskId& taskId, const TaskId& blockerId,
+                                     bool added, const QString& text)
+    : TaskCommand(tree, text), taskId(taskId), blockerId(blockerId), added(added)
+{
+}
+
+void DependencyCommand::redo()
+{
+    apply(added);
+}
+
+void DependencyCommand::undo()
+{
+    apply(!added);
+}
+
+qint64 DependencyCommand::byteSize() const
+{
+    return sizeof(*this);
+}
+
+void DependencyCommand::apply(bool add)
+{
+    if (add) {
+        tree->addDependency(taskId, blockerId);
+    } else {
+        tree->removeDependency(taskId, blockerId);
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef TASKCOMMANDS_H
+#define TASKCOMMANDS_H
+#include <QUndoCommand>
+#include <QByteArray>
+#include "taskdelta.h"
+
+class TaskTreeWidget;
+
+// Undoable changes to the tree. Each command keeps only what its change touched:
+// a field delta for an edit, or the removed tasks encoded once in binary form,
+// so undo and redo cost as much as the change did, not a copy of the board.
+// Commands go through the tree's normal mutation calls, and a task that has
+// gone in the meantime (archived, or removed by another instance) is skipped.
+class TaskCommand : public QUndoCommand
+{
+public:
+    TaskCommand(TaskTreeWidget* tree, const QString& text);
+    virtual qint64 byteSize() const = 0;
+
+protected:
+    TaskTreeWidget* tree;
+};
+
+// Inserts tasks whose ids are already set; a batch is one command
+class AddTasksCommand : public TaskCommand
+{
+public:
+    AddTasksCommand(TaskTreeWidget* tree, const QList<Task>& tasks, const QString& text);
+    void redo() override;
+    void undo() override;
+    qint64 byteSize() const override;
+
+private:
+    QByteArray records;
+    QList<TaskId> rootIds;
+};
+
+// Removes tasks with their subtasks; undo puts each subtree back in its old place
+// and restores the blockers it had on tasks outside it
+class RemoveTasksCommand : public TaskCommand
+{
+public:
+    RemoveTasksCommand(TaskTreeWidget* tree, const QList<TaskId>& taskIds, const QString& text);
+    void redo() override;
+    void undo() override;
+    qint64 byteSize() const override;
+
+private:
+    QByteArray records;
+    QList<TaskId> rootIds;
+};
+
+class EditTaskCommand : public TaskCommand
+{
+public:
+    EditTaskCommand(TaskTreeWidget* tree, const TaskId& taskId, const TaskDelta& delta, const QString& text);
+    void redo() override;
+    void undo() override;
+    qint64 byteSize() const override;
+
+private:
+    TaskId taskId;
+    TaskDelta delta;
+};
+
+class DependencyCommand : public TaskCommand
+{
+public:
+    DependencyCommand(TaskTreeWidget* tree, const TaskId& taskId, const TaskId& blockerId, bool added,
+                      const QString& text);
+    void redo() override;
+    void undo() override;
+    qint64 byteSize() const override;
+
+private:
+    TaskId taskId;
+    TaskId blockerId;
+    bool added;
+
+    void apply(bool add);
+};
+
+#endif // TASKCOMMANDS_H
@@ -0,0 +1,129 @@
+#include "taskdelta.h"
+#include "stringpool.h"
+#include <QDataStream>
+
+namespace {
+
+const TaskDelta::Field Fields[] = {
+    TaskDelta::Title, TaskDelta::Description, TaskDelta::DueDate, TaskDelta::Priority,
+    TaskDelta::Completion, TaskDelta::Tags, TaskDelta::RecurrenceRule
+};
+
+void writeField(QDataStream& out, const Task& task, TaskDelta::Field field)
+{
+    switch (field) {
+    case TaskDelta::Title:
+        out << task.title;
+        break;
+    case TaskDelta::Description:
+        out << task.description << task.descriptionOffset << task.descriptionSize;
+        break;
+    case TaskDelta::DueDate:
+        out << task.dueDate;
+        break;
+    case TaskDelta::Priority:
+        out << task.priority;
+        break;
+    case TaskDelta::Completion:
+        out << task.completed << task.completedDate;
+        break;
+    case TaskDelta::Tags:
+        out << task.tags;
+        break;
+    case TaskDelta::RecurrenceRule:
+        out << task.recurrence;
+        break;
+    }
+}
+
+void readField(QDataStream& in, Task& task, TaskDelta::Field field)
+{
+    switch (field) {
+    case TaskDelta::Title:
+        in >> task.title;
+        break;
+    case TaskDelta::Description:
+        in >> task.description >> task.descriptionOffset >> task.descriptionSize;
+        break;
+    case TaskDelta::DueDate:
+        in >> task.dueDate;
+        break;
+    case TaskDelta::Priority:
+        in >> task.priority;
+        task.priority = StringPool::shared().intern(task.priority);
+        break;
+    case TaskDelta::Completion:
+        in >> task.completed >> task.completedDate;
+        break;
+    case TaskDelta::Tags:
+        in >> task.tags;
+        StringPool::shared().intern(task.tags);
+        break;
+    case TaskDelta::RecurrenceRule:
+        in >> task.recurrence;
+        break;
+    }
+}
+
+QByteArray encodeField(const Task& task, TaskDelta::Field field)
+{
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_15);
+    writeField(out, task, field);
+    return bytes;
+}
+
+void decodeFields(const QByteArray& bytes, quint32 fields, Task& task)
+{
+    QDataStream in(bytes);
+    in.setVersion(QDataStream::Qt_5_15);
+    for (TaskDelta::Field field : Fields) {
+        if (fields & field) {
+            readField(in, task, field);
+        }
+    }
+}
+
+} // namespace
+
+TaskDelta TaskDelta::between(const Task& before, const Task& after)
+{
+    // Fields are compared in encoded form, which also covers the recurrence rule
+    TaskDelta delta;
+    for (Field field : Fields) {
+        QByteArray oldBytes = encodeField(before, field);
+        QByteArray newBytes = encodeField(after, field);
+        if (oldBytes != newBytes) {
+            delta.changed |= field;
+            delta.before += oldBytes;
+            delta.after += newBytes;
+        }
+    }
+    return delta;
+}
+
+bool TaskDelta::isEmpty() const
+{
+    return changed == 0;
+}
+
+quint32 TaskDelta::fields() const
+{
+    return changed;
+}
+
+void TaskDelta::applyBefore(Task& task) const
+{
+    decodeFields(before, changed, task);
+}
+
+void TaskDelta::applyAfter(Task& task) const
+{
+    decodeFields(after, changed, task);
+}
+
+qint64 TaskDelta::byteSize() const
+{
+    return before.size() + after.size();
+}
@@ -0,0 +1,37 @@
+#ifndef TASKDELTA_H
+#define TASKDELTA_H
+#include <QByteArray>
+#include "task.h"
+
+// The editable fields that differ between two versions of a task. Only those
+// fields are kept, encoded once for each side, so an edit that renames a task
+// costs a title's worth of memory whatever else the task holds. Structure
+// (parent, subtasks, blockers) is not covered; it has its own operations.
+class TaskDelta
+{
+public:
+    enum Field {
+        Title = 0x01,
+        Description = 0x02,
+        DueDate = 0x04,
+        Priority = 0x08,
+        Completion = 0x10,
+        Tags = 0x20,
+        RecurrenceRule = 0x40
+    };
+
+    static TaskDelta between(const Task& before, const Task& after);
+
+    bool isEmpty() const;
+    quint32 fields() const;
+    void applyBefore(Task& task) const;
+    void applyAfter(Task& task) const;
+    qint64 byteSize() const;
+
+private:
+    quint32 changed = 0;
+    QByteArray before;
+    QByteArray after;
+};
+
+#endif // TASKDELTA_H
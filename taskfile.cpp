@@ -0,0 +1,156 @@
+#include "taskfile.h"
+#include <QJsonDocument>
+
+namespace {
+
+const qint64 ReadChunkBytes = 256 * 1024;
+
+bool isSeparator(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == ',' || c == '[';
+}
+
+}
+
+bool TaskFileReader::open(const QString& path)
+{
+    file.close();
+    file.setFileName(path);
+    buffer.clear();
+    pos = 0;
+    error.clear();
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool TaskFileReader::next(Task& task)
+{
+    QJsonObject object;
+    if (!nextObject(object)) return false;
+    task = Task::fromJson(object);
+    return true;
+}
+
+bool TaskFileReader::nextObject(QJsonObject& object)
+{
+    if (!error.isEmpty()) return false;
+
+    // Find where the next element starts
+    for (;;) {
+        if (pos >= buffer.size()) {
+            buffer.clear();
+            pos = 0;
+            if (!fill()) return false; // An unterminated array ends like a terminated one
+        }
+        char c = buffer[pos];
+        if (c == '{') break;
+        if (c == ']') return false;
+        if (!isSeparator(c)) {
+            error = QString("Unexpected '%1' at byte %2").arg(QChar(c)).arg(bytesRead() - (buffer.size() - pos));
+            return false;
+        }
+        pos++;
+    }
+
+    // Find the matching brace; only quotes and escapes need tracking
+    int scan = pos;
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+    for (;;) {
+        if (scan >= buffer.size()) {
+            buffer.remove(0, pos);
+            scan -= pos;
+            pos = 0;
+            if (!fill()) {
+                error = "The file ends inside a task";
+                return false;
+            }
+        }
+        char c = buffer[scan++];
+        if (inString) {
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                inString = false;
+            }
+        } else if (c == '"') {
+            inString = true;
+        } else if (c == '{') {
+            depth++;
+        } else if (c == '}' && --depth == 0) {
+            break;
+        }
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(buffer.mid(pos, scan - pos), &parseError);
+    pos = scan;
+    if (!document.isObject()) {
+        error = parseError.errorString();
+        return false;
+    }
+    object = document.object();
+    return true;
+}
+
+void TaskFileReader::close()
+{
+    file.close();
+    buffer.clear();
+    pos = 0;
+}
+
+bool TaskFileReader::hasError() const
+{
+    return !error.isEmpty();
+}
+
+QString TaskFileReader::errorString() const
+{
+    return error;
+}
+
+qint64 TaskFileReader::bytesRead() const
+{
+    return file.pos();
+}
+
+bool TaskFileReader::fill()
+{
+    QByteArray chunk = file.read(ReadChunkBytes);
+    if (chunk.isEmpty()) return false;
+    buffer += chunk;
+    return true;
+}
+
+bool TaskFileWriter::open(const QString& path)
+{
+    file.setFileName(path);
+    count = 0;
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write("[");
+    return true;
+}
+
+void TaskFileWriter::write(const Task& task)
+{
+    file.write(count++ > 0 ? ",\n" : "\n");
+    file.write(QJsonDocument(task.toJson()).toJson(QJsonDocument::Compact));
+}
+
+bool TaskFileWriter::commit()
+{
+    file.write(count > 0 ? "\n]\n" : "]\n");
+    return file.commit();
+}
+
+QString TaskFileWriter::errorString() const
+{
+    return file.errorString();
+}
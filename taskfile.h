@@ -0,0 +1,45 @@
+#ifndef TASKFILE_H
+#define TASKFILE_H
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonObject>
+#include "task.h"
+
+// The task file is a JSON array with one object per task. These classes read
+// and write it one task at a time, so a board of any size passes through a
+// fixed-size buffer. The reader takes any layout, including the indented files
+// earlier versions wrote; the writer puts one compact object on each line.
+class TaskFileReader
+{
+public:
+    bool open(const QString& path);
+    bool next(Task& task); // False at the end of the array or on a malformed entry
+    void close();
+    bool hasError() const;
+    QString errorString() const;
+    qint64 bytesRead() const;
+
+private:
+    QFile file;
+    QByteArray buffer;
+    int pos = 0;
+    QString error;
+
+    bool nextObject(QJsonObject& object);
+    bool fill();
+};
+
+class TaskFileWriter
+{
+public:
+    bool open(const QString& path);
+    void write(const Task& task);
+    bool commit(); // Replaces the file only if every write succeeded
+    QString errorString() const;
+
+private:
+    QSaveFile file;
+    qint64 count = 0;
+};
+
+#endif // TASKFILE_H
@@ -0,0 +1,72 @@
+#include "taskid.h"
+#include <QRandomGenerator>
+#include <QUuid>
+
+namespace {
+
+// Names non-UUID ids from hand-edited or foreign files, so they map to the same
+// TaskId every time they are read
+const QUuid LegacyIdNamespace("{6f1c2a4e-8d3b-4f5a-9c7e-2b1d0e3f4a5c}");
+
+}
+
+TaskId TaskId::create()
+{
+    QRandomGenerator* generator = QRandomGenerator::global();
+    quint64 high = generator->generate64();
+    quint64 low = generator->generate64();
+
+    // Version 4, RFC 4122 variant, like QUuid::createUuid()
+    high = (high & ~Q_UINT64_C(0xF000)) | Q_UINT64_C(0x4000);
+    low = (low & Q_UINT64_C(0x3FFFFFFFFFFFFFFF)) | Q_UINT64_C(0x8000000000000000);
+    return TaskId(high, low);
+}
+
+TaskId TaskId::fromString(const QString& text)
+{
+    if (text.isEmpty()) return TaskId();
+
+    QUuid uuid = QUuid::fromString(text);
+    if (uuid.isNull()) {
+        uuid = QUuid::createUuidV5(LegacyIdNamespace, text);
+    }
+
+    quint64 high = (quint64(uuid.data1) << 32) | (quint64(uuid.data2) << 16) | uuid.data3;
+    quint64 low = 0;
+    for (int i = 0; i < 8; ++i) {
+        low = (low << 8) | uuid.data4[i];
+    }
+    return TaskId(high, low);
+}
+
+QString TaskId::toString() const
+{
+    if (isNull()) return QString();
+
+    // xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx, the same text QUuid writes without braces
+    static const char digits[] = "0123456789abcdef";
+    QString text(36, QLatin1Char('-'));
+    QChar* out = text.data();
+    int pos = 0;
+    for (int nibble = 0; nibble < 32; ++nibble) {
+        if (pos == 8 || pos == 13 || pos == 18 || pos == 23) pos++;
+        quint64 word = nibble < 16 ? high : low;
+        int shift = 60 - 4 * (nibble % 16);
+        out[pos++] = QLatin1Char(digits[(word >> shift) & 0xF]);
+    }
+    return text;
+}
+
+QDataStream& operator<<(QDataStream& out, const TaskId& id)
+{
+    return out << id.highBits() << id.lowBits();
+}
+
+QDataStream& operator>>(QDataStream& in, TaskId& id)
+{
+    quint64 high = 0;
+    quint64 low = 0;
+    in >> high >> low;
+    id = in.status() == QDataStream::Ok ? TaskId(high, low) : TaskId();
+    return in;
+}
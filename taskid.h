@@ -0,0 +1,55 @@
+#ifndef TASKID_H
+#define TASKID_H
+#include <QString>
+#include <QMetaType>
+#include <QDataStream>
+#include <QtGlobal>
+
+// 128-bit task identifier held as two integers. New ids are random version-4
+// UUIDs drawn from the process-wide PRNG, so minting one neither allocates nor
+// waits on the system entropy source; the textual UUID form is only produced for
+// files and the journal. A default-constructed id is null ("no task").
+class TaskId
+{
+public:
+    TaskId() = default;
+
+    static TaskId create();
+    static TaskId fromString(const QString& text);
+
+    bool isNull() const { return high == 0 && low == 0; }
+    QString toString() const;
+
+    bool operator==(const TaskId& other) const { return high == other.high && low == other.low; }
+    bool operator!=(const TaskId& other) const { return !(*this == other); }
+    bool operator<(const TaskId& other) const { return high != other.high ? high < other.high : low < other.low; }
+
+    quint64 highBits() const { return high; }
+    quint64 lowBits() const { return low; }
+
+private:
+    quint64 high = 0;
+    quint64 low = 0;
+
+    TaskId(quint64 high, quint64 low) : high(high), low(low) {}
+
+    friend QDataStream& operator>>(QDataStream& in, TaskId& id);
+};
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+inline size_t qHash(const TaskId& id, size_t seed = 0)
+#else
+inline uint qHash(const TaskId& id, uint seed = 0)
+#endif
+{
+    // The bits are already random; fold them with the seed
+    quint64 mixed = id.highBits() ^ (id.lowBits() * Q_UINT64_C(0x9E3779B97F4A7C15));
+    return decltype(seed)(mixed ^ (mixed >> 32)) ^ seed;
+}
+
+QDataStream& operator<<(QDataStream& out, const TaskId& id);
+QDataStream& operator>>(QDataStream& in, TaskId& id);
+
+Q_DECLARE_METATYPE(TaskId)
+
+#endif // TASKID_H
@@ -1,16 +1,49 @@
 #include "taskmanager.h"
+#include "taskcommands.h"
+#include "taskfile.h"
+#include <QtConcurrent>
+
+// Memory the undo history may hold before it forgets its oldest steps
+static const qint64 UndoHistoryBytes = 8 * 1024 * 1024;
+
+template <typename ForEach>
+static bool writeTaskFile(const QString& filePath, ForEach forEach)
+{
+    TaskFileWriter writer;
+    if (!writer.open(filePath)) {
+        return false;
+    }
+    forEach([&writer](const Task& task) {
+        writer.write(task);
+    });
+    return writer.commit();
+}
 
 TaskManager::TaskManager(QWidget *parent)
     : QMainWindow(parent)
 {
+    history = new UndoHistory(UndoHistoryBytes, this);
     setupUI();
     connectSignals();
     loadTasks();
+    updateStatistics();
+    updateTagCounts();
+
+    // Join other windows on the same file only once this one has loaded it
+    syncPeer = new SyncPeer(taskTree, &descriptions, dataFilePath("tasks_with_subtasks.json"), this);
+    connect(syncPeer, &SyncPeer::remoteChangesApplied, this, &TaskManager::onRemoteChangesApplied);
+    syncPeer->start();
+
+    reminders = new ReminderScheduler(taskTree, this);
+    reminders->setLeadMinutes(QSettings(dataFilePath("settings.ini"), QSettings::IniFormat)
+                                  .value("reminders/leadMinutes", 15).toInt());
+    connect(reminders, &ReminderScheduler::reminder, this, &TaskManager::onReminder);
 }
 
 TaskManager::~TaskManager()
 {
-    saveTasks();
+    saveWatcher.waitForFinished();
+    writeSnapshot(taskTree->getAllTasks());
 }
 
 void TaskManager::addTask()
@@ -21,10 +54,14 @@ void TaskManager::addTask()
         return;
     }
 
-    Task task(title, descEdit->toPlainText(), dueDateEdit->dateTime(),
+    Task task(title, QString(), dueDateEdit->dateTime(),
               priorityCombo->currentText(), false);
+    task.tags = Task::parseTags(tagsEdit->text());
+    task.recurrence = recurrenceFromInputs(task.dueDate);
+    descriptions.store(task, descEdit->toPlainText());
 
-    taskTree->addTask(task);
+    task.id = TaskId::create();
+    history->push(new AddTasksCommand(taskTree, {task}, "Add Task"));
     clearInputs();
     saveTasks();
 }
@@ -41,11 +78,17 @@ void TaskManager::addSubtask() {
         return;
     }
 
-    QString parentId = taskTree->getSelectedTaskId();
-    Task subtask(title, descEdit->toPlainText(), dueDateEdit->dateTime(),
+    TaskId parentId = taskTree->getSelectedTaskId();
+    Task subtask(title, QString(), dueDateEdit->dateTime(),
                  priorityCombo->currentText(), false);
-
-    taskTree->addSubtask(parentId, subtask);
+    subtask.tags = Task::parseTags(tagsEdit->text());
+    subtask.recurrence = recurrenceFromInputs(subtask.dueDate);
+    descriptions.store(subtask, descEdit->toPlainText());
+
+    subtask.id = TaskId::create();
+    subtask.parentId = parentId;
+    subtask.level = taskTree->getTaskById(parentId).level + 1;
+    history->push(new AddTasksCommand(taskTree, {subtask}, "Add Subtask"));
     clearInputs();
     saveTasks();
 }
@@ -54,15 +97,24 @@ void TaskManager::addSubtask() {
 void TaskManager::editTask()
 {
     Task task = taskTree->getSelectedTask();
-    if (task.id.isEmpty()) {
+    if (task.id.isNull()) {
         QMessageBox::warning(this, "Warning", "Please select a task to edit.");
         return;
     }
 
     titleEdit->setText(task.title);
-    descEdit->setPlainText(task.description);
+    descEdit->setPlainText(descriptions.text(task));
     dueDateEdit->setDateTime(task.dueDate);
     priorityCombo->setCurrentText(task.priority);
+    tagsEdit->setText(task.tags.join(", "));
+
+    // Saving restarts the series from the occurrence shown as the due date
+    repeatCombo->setCurrentIndex(task.recurrence.frequency());
+    repeatIntervalSpin->setValue(task.recurrence.interval());
+    repeatUntilCheck->setChecked(task.recurrence.until().isValid());
+    if (task.recurrence.until().isValid()) {
+        repeatUntilEdit->setDate(task.recurrence.until());
+    }
 
     editButton->setEnabled(false);
     updateButton->setEnabled(true);
@@ -77,23 +129,36 @@ void TaskManager::updateTask()
         return;
     }
 
-    if (currentEditId.isEmpty()) return;
-
-    Task task(title, descEdit->toPlainText(), dueDateEdit->dateTime(),
-              priorityCombo->currentText(), false);
+    if (currentEditId.isNull()) return;
+
+    // Only the fields the form shows are edited, and only the changed ones are kept for undo
+    Task current = taskTree->getTaskById(currentEditId);
+    Task task = current;
+    task.title = title;
+    task.dueDate = dueDateEdit->dateTime();
+    task.priority = priorityCombo->currentText();
+    task.tags = Task::parseTags(tagsEdit->text());
+    task.recurrence = recurrenceFromInputs(task.dueDate);
+    QString description = descEdit->toPlainText();
+    if (description != descriptions.text(current)) {
+        descriptions.store(task, description);
+    }
 
-    taskTree->updateTask(currentEditId, task);
+    TaskDelta delta = TaskDelta::between(current, task);
+    if (!current.id.isNull() && !delta.isEmpty()) {
+        history->push(new EditTaskCommand(taskTree, currentEditId, delta, "Edit Task"));
+    }
     clearInputs();
     editButton->setEnabled(true);
     updateButton->setEnabled(false);
-    currentEditId.clear();
+    currentEditId = TaskId();
     saveTasks();
 }
 
 void TaskManager::deleteTask()
 {
-    QString taskId = taskTree->getSelectedTaskId();
-    if (taskId.isEmpty()) {
+    TaskId taskId = taskTree->getSelectedTaskId();
+    if (taskId.isNull()) {
         QMessageBox::warning(this, "Warning", "Please select a task to delete.");
         return;
     }
@@ -108,19 +173,116 @@ void TaskManager::deleteTask()
                                                               message, QMessageBox::Yes | QMessageBox::No);
 
     if (reply == QMessageBox::Yes) {
-        taskTree->removeTask(taskId);
+        history->push(new RemoveTasksCommand(taskTree, {taskId}, "Delete Task"));
         saveTasks();
     }
 }
 
+void TaskManager::addBlocker()
+{
+    TaskId taskId = taskTree->getSelectedTaskId();
+    if (taskId.isNull()) {
+        QMessageBox::warning(this, "Warning", "Please select a task first.");
+        return;
+    }
+
+    // Leave out what cannot or need not block it: its own subtree, tasks already
+    // waiting on it (a cycle), its current blockers and finished tasks
+    const DependencyGraph& dependencies = taskTree->getDependencies();
+    QSet<TaskId> excluded;
+    for (const Task& task : taskTree->getSubtree(taskId)) {
+        excluded.insert(task.id);
+    }
+    QList<TaskId> pending = {taskId};
+    for (int i = 0; i < pending.size(); ++i) {
+        for (const TaskId& dependentId : dependencies.dependents(pending[i])) {
+            if (!excluded.contains(dependentId)) {
+                excluded.insert(dependentId);
+                pending.append(dependentId);
+            }
+        }
+    }
+    for (const TaskId& blockerId : dependencies.blockers(taskId)) {
+        excluded.insert(blockerId);
+    }
+
+    // Numbered, so tasks with the same title and date still pick the right one
+    QList<TaskId> candidates;
+    QStringList labels;
+    taskTree->getStore().forEach([&](const Task& task) {
+        if (task.completed || excluded.contains(task.id)) return;
+        candidates.append(task.id);
+        labels.append(QString("%1. %2 (due %3)")
+                          .arg(labels.size() + 1)
+                          .arg(task.title, task.dueDate.toString("MMM dd, yyyy")));
+    });
+    if (candidates.isEmpty()) {
+        QMessageBox::information(this, "Add Blocker", "There are no other tasks that could block this one.");
+        return;
+    }
+
+    bool ok = false;
+    QString choice = QInputDialog::getItem(this, "Add Blocker", "Blocked by:", labels, 0, false, &ok);
+    int index = labels.indexOf(choice);
+    if (!ok || index < 0) return;
+
+    if (!taskTree->addDependency(taskId, candidates[index])) {
+        QMessageBox::warning(this, "Warning", "That task already depends on this one; "
+                                              "adding it would create a circular dependency.");
+        return;
+    }
+    history->record(new DependencyCommand(taskTree, taskId, candidates[index], true, "Add Blocker"));
+    saveTasks();
+    onTaskSelectionChanged();
+}
+
+void TaskManager::removeBlocker()
+{
+    Task task = taskTree->getSelectedTask();
+    if (task.blockedBy.isEmpty()) return;
+
+    // Numbered, so blockers with the same title still remove the right one
+    QStringList labels;
+    for (const TaskId& blockerId : task.blockedBy) {
+        labels.append(QString("%1. %2").arg(labels.size() + 1).arg(taskTree->getTaskById(blockerId).title));
+    }
+
+    bool ok = false;
+    QString choice = QInputDialog::getItem(this, "Remove Blocker", "No longer blocked by:", labels, 0, false, &ok);
+    int index = labels.indexOf(choice);
+    if (!ok || index < 0) return;
+
+    history->push(new DependencyCommand(taskTree, task.id, task.blockedBy[index], false, "Remove Blocker"));
+    saveTasks();
+    onTaskSelectionChanged();
+}
+
+void TaskManager::showCriticalPath()
+{
+    QList<TaskId> path = taskTree->getDependencies().criticalPath();
+    if (path.isEmpty()) {
+        QMessageBox::information(this, "Critical Path", "There are no pending tasks.");
+        return;
+    }
+
+    QString text;
+    for (int i = 0; i < path.size(); ++i) {
+        Task task = taskTree->getTaskById(path[i]);
+        text += QString("%1. %2 (due %3)\n").arg(i + 1).arg(task.title, task.dueDate.toString("MMM dd, yyyy"));
+    }
+    QMessageBox::information(this, "Critical Path", text);
+}
+
 void TaskManager::onTaskSelectionChanged()
 {
     Task task = taskTree->getSelectedTask();
-    bool hasSelection = !task.id.isEmpty();
+    bool hasSelection = !task.id.isNull();
 
     editButton->setEnabled(hasSelection);
     deleteButton->setEnabled(hasSelection);
     addSubtaskButton->setEnabled(hasSelection);
+    addBlockerButton->setEnabled(hasSelection);
+    removeBlockerButton->setEnabled(hasSelection && !task.blockedBy.isEmpty());
 
     if (hasSelection) {
         QString statusText = task.completed ? "Completed" : "Pending";
@@ -128,6 +290,23 @@ void TaskManager::onTaskSelectionChanged()
             int progress = taskTree->getTaskProgress(task.id);
             statusText += QString(" (%1% subtasks complete)").arg(progress);
         }
+        if (taskTree->getDependencies().isBlocked(task.id)) {
+            statusText += ", blocked";
+        }
+
+        if (task.recurrence.isRecurring()) {
+            // Only the next two weeks are expanded, however long the series runs
+            QDate today = QDate::currentDate();
+            int upcoming = task.recurrence.openBetween(today, today.addDays(13)).size();
+            statusText += QString(", repeats %1 (%2 open in the next 14 days)")
+                              .arg(task.recurrence.describe())
+                              .arg(upcoming);
+        }
+
+        QStringList blockerTitles;
+        for (const TaskId& blockerId : task.blockedBy) {
+            blockerTitles.append(taskTree->getTaskById(blockerId).title.toHtmlEscaped());
+        }
 
         taskDetailsLabel->setText(QString(
                                       "<b>Created:</b> %1<br>"
@@ -135,31 +314,218 @@ void TaskManager::onTaskSelectionChanged()
                                       "<b>Priority:</b> %3<br>"
                                       "<b>Status:</b> %4<br>"
                                       "<b>Type:</b> %5<br>"
-                                      "<b>Subtasks:</b> %6<br><br>"
-                                      "<b>Description:</b><br>%7")
+                                      "<b>Subtasks:</b> %6<br>"
+                                      "<b>Tags:</b> %7<br>"
+                                      "<b>Blocked By:</b> %8<br><br>"
+                                      "<b>Description:</b><br>%9")
                                       .arg(task.createdDate.toString("MMM dd, yyyy hh:mm"))
                                       .arg(task.dueDate.toString("MMM dd, yyyy hh:mm"))
                                       .arg(task.priority)
                                       .arg(statusText)
                                       .arg(task.isMainTask() ? "Main Task" : "Subtask")
                                       .arg(task.subtaskIds.size())
-                                      .arg(task.description));
+                                      .arg(task.tags.join(", "))
+                                      .arg(blockerTitles.join(", "))
+                                      .arg(descriptions.text(task)));
     } else {
         taskDetailsLabel->clear();
     }
 }
 
-void TaskManager::onTaskToggled(const QString& taskId)
+void TaskManager::onTaskToggled(const TaskId& taskId)
 {
     saveTasks();
 }
 
+void TaskManager::undo()
+{
+    history->undo();
+    saveTasks();
+    onTaskSelectionChanged();
+}
+
+void TaskManager::redo()
+{
+    history->redo();
+    saveTasks();
+    onTaskSelectionChanged();
+}
+
+void TaskManager::updateUndoActions()
+{
+    undoAction->setEnabled(history->canUndo());
+    undoAction->setText(history->canUndo() ? QString("&Undo %1").arg(history->undoText()) : QString("&Undo"));
+    redoAction->setEnabled(history->canRedo());
+    redoAction->setText(history->canRedo() ? QString("&Redo %1").arg(history->redoText()) : QString("&Redo"));
+}
+
+void TaskManager::onAgendaTaskSelected(const TaskId& taskId)
+{
+    // The details panel follows the tree; rows hidden by the tree's filter stay unselected there
+    if (!taskTree->selectTask(taskId)) {
+        taskTree->setCurrentItem(nullptr);
+    }
+}
+
+void TaskManager::onTaskMoved(const TaskId& taskId, const TaskId& newParentId, int index)
+{
+    // A move only touches one task's links, so journal it instead of rewriting everything
+    QJsonObject delta;
+    delta["op"] = "move";
+    delta["id"] = taskId.toString();
+    delta["parentId"] = newParentId.toString();
+    delta["index"] = index;
+    appendDelta(delta);
+}
+
+void TaskManager::updateStatistics()
+{
+    const TaskStats& stats = taskTree->getStatistics();
+
+    QString text = QString("<b>Total:</b> %1 &nbsp; <b>Completed:</b> %2 (%3%) &nbsp; <b>Pending:</b> %4<br>")
+                       .arg(stats.totalCount())
+                       .arg(stats.completedCount())
+                       .arg(stats.completionPercent())
+                       .arg(stats.pendingCount());
+    text += QString("<b>High:</b> %1 &nbsp; <b>Medium:</b> %2 &nbsp; <b>Low:</b> %3<br>")
+                .arg(stats.priorityCount("High"))
+                .arg(stats.priorityCount("Medium"))
+                .arg(stats.priorityCount("Low"));
+    text += QString("<b>Overdue:</b> %1 &nbsp; <b>Due Today:</b> %2 &nbsp; <b>Due This Week:</b> %3")
+                .arg(stats.dueCount(TaskStats::Overdue))
+                .arg(stats.dueCount(TaskStats::DueToday))
+                .arg(stats.dueCount(TaskStats::DueThisWeek));
+
+    TaskId selectedId = taskTree->getSelectedTaskId();
+    if (!selectedId.isNull()) {
+        TaskId rootId = taskTree->getRootTaskId(selectedId);
+        TaskStats::Progress progress = stats.rootProgress(rootId);
+        text += QString("<br><b>%1:</b> %2/%3 tasks (%4%)")
+                    .arg(taskTree->getTaskById(rootId).title.toHtmlEscaped())
+                    .arg(progress.completed)
+                    .arg(progress.total)
+                    .arg(progress.percent());
+    }
+
+    statsLabel->setText(text);
+}
+
+void TaskManager::applyTagQuery()
+{
+    taskTree->applyQuery(queryEdit->text());
+    updateTagCounts();
+}
+
+void TaskManager::updateTagCounts()
+{
+    QString error = taskTree->getQueryError();
+    if (!error.isEmpty()) {
+        tagCountsLabel->setText(QString("<font color=\"red\">%1</font>").arg(error.toHtmlEscaped()));
+        return;
+    }
+
+    const TagIndex& tagIndex = taskTree->getTagIndex();
+    QStringList counts;
+    for (const QString& tag : tagIndex.tags()) {
+        counts.append(QString("%1 (%2)").arg(tag.toHtmlEscaped()).arg(tagIndex.tagCount(tag)));
+    }
+    tagCountsLabel->setText(counts.isEmpty() ? QString() : "<b>Tags:</b> " + counts.join(", "));
+}
+
 void TaskManager::filterTasks()
 {
     QString filter = filterCombo->currentText();
     taskTree->applyFilter(filter);
 }
 
+void TaskManager::archiveCompletedTasks()
+{
+    int archived = archiveFinishedTasks();
+    if (archived > 0) {
+        saveTasks();
+    }
+    QMessageBox::information(this, "Archive",
+                             QString("Archived %1 completed task tree(s) older than %2 day(s).")
+                                 .arg(archived).arg(archiveAgeDays()));
+}
+
+void TaskManager::restoreArchivedTask()
+{
+    // Trees restored but not saved yet are still in the archive
+    QList<TaskArchive::Entry> entries;
+    for (const TaskArchive::Entry& entry : archive.entries()) {
+        if (!taskTree->getStore().contains(entry.rootId)) {
+            entries.append(entry);
+        }
+    }
+    if (entries.isEmpty()) {
+        QMessageBox::information(this, "Archive", "The archive is empty.");
+        return;
+    }
+
+    // Numbered, so entries with the same title and date still pick the right tree
+    QStringList labels;
+    for (const TaskArchive::Entry& entry : entries) {
+        labels.append(QString("%1. %2 (%3 tasks, completed %4)")
+                          .arg(labels.size() + 1)
+                          .arg(entry.title)
+                          .arg(entry.taskCount)
+                          .arg(entry.completedDate.toString("MMM dd, yyyy")));
+    }
+
+    bool ok = false;
+    QString choice = QInputDialog::getItem(this, "Restore Archived Task", "Archived tasks:",
+                                           labels, 0, false, &ok);
+    int index = labels.indexOf(choice);
+    if (!ok || index < 0) return;
+
+    QList<Task> tasks = archive.load(entries[index].rootId);
+    if (tasks.isEmpty()) return;
+    for (Task& task : tasks) {
+        // Restart the archive age so the tree is not archived again on the next start
+        if (task.completed) {
+            task.completedDate = QDateTime::currentDateTime();
+        }
+        descriptions.store(task, task.description);
+    }
+    taskTree->addTasks(tasks);
+    restoredRoots.append(entries[index].rootId);
+    saveTasks();
+}
+
+void TaskManager::setArchiveAge()
+{
+    bool ok = false;
+    int days = QInputDialog::getInt(this, "Archive Age", "Archive completed tasks after (days):",
+                                    archiveAgeDays(), 0, 3650, 1, &ok);
+    if (ok) {
+        QSettings settings(dataFilePath("settings.ini"), QSettings::IniFormat);
+        settings.setValue("archive/ageDays", days);
+    }
+}
+
+void TaskManager::onReminder(const TaskId& taskId, ReminderScheduler::Kind kind)
+{
+    Task task = taskTree->getTaskById(taskId);
+    QString text = kind == ReminderScheduler::DueNow
+                       ? QString("Due now: %1").arg(task.title)
+                       : QString("Due at %1: %2").arg(task.dueDate.toString("hh:mm"), task.title);
+    statusBar()->showMessage(text, 30000);
+    QApplication::alert(this);
+}
+
+void TaskManager::setReminderLeadTime()
+{
+    bool ok = false;
+    int minutes = QInputDialog::getInt(this, "Reminders", "Remind this many minutes before a task is due (0 for none):",
+                                       reminders->leadMinutes(), 0, 7 * 24 * 60, 5, &ok);
+    if (ok) {
+        QSettings settings(dataFilePath("settings.ini"), QSettings::IniFormat);
+        settings.setValue("reminders/leadMinutes", minutes);
+        reminders->setLeadMinutes(minutes);
+    }
+}
+
 void TaskManager::setupUI()
 {
     centralWidget = new QWidget();
@@ -169,6 +535,7 @@ void TaskManager::setupUI()
 
     setupLeftPanel();
     setupRightPanel();
+    setupMenus();
 
     mainSplitter->addWidget(leftPanel);
     mainSplitter->addWidget(rightPanel);
@@ -191,16 +558,34 @@ void TaskManager::setupLeftPanel()
     // Filter
     QLabel* filterLabel = new QLabel("Filter:");
     filterCombo = new QComboBox();
+    filterCombo->setObjectName("filterCombo");
     filterCombo->addItems({"All Tasks", "Pending", "Completed", "High Priority",
-                           "Due Today", "Main Tasks Only"});
+                           "Due Today", "Main Tasks Only", "Ready", "Blocked"});
+
+    showAncestorsCheck = new QCheckBox("Show parents of matching subtasks");
 
-    // Task tree
+    // Tag query
+    queryEdit = new QLineEdit();
+    queryEdit->setPlaceholderText("Tag query, e.g. tag:backend AND tag:urgent AND NOT done");
+    queryEdit->setClearButtonEnabled(true);
+    tagCountsLabel = new QLabel();
+    tagCountsLabel->setWordWrap(true);
+
+    // Task tree, and the same tasks as a flat list by due date
     taskTree = new TaskTreeWidget();
+    taskTree->setObjectName("taskTree");
+    agendaView = new AgendaView(taskTree);
+    viewTabs = new QTabWidget();
+    viewTabs->addTab(taskTree, "Tree");
+    viewTabs->addTab(agendaView, "Agenda");
 
     leftLayout->addWidget(filterLabel);
     leftLayout->addWidget(filterCombo);
+    leftLayout->addWidget(showAncestorsCheck);
+    leftLayout->addWidget(queryEdit);
+    leftLayout->addWidget(tagCountsLabel);
     leftLayout->addWidget(new QLabel("Tasks:"));
-    leftLayout->addWidget(taskTree);
+    leftLayout->addWidget(viewTabs);
 
 }
 
@@ -227,6 +612,29 @@ void TaskManager::setupRightPanel()
     priorityCombo->addItems({"Low", "Medium", "High"});
     priorityCombo->setCurrentText("Medium");
 
+    tagsEdit = new QLineEdit();
+    tagsEdit->setPlaceholderText("Comma-separated tags, e.g. backend, sprint-12");
+
+    // Order matches Recurrence::Frequency
+    repeatCombo = new QComboBox();
+    repeatCombo->addItems({"Never", "Daily", "Weekly", "Monthly"});
+
+    repeatIntervalSpin = new QSpinBox();
+    repeatIntervalSpin->setRange(1, 365);
+    repeatIntervalSpin->setPrefix("every ");
+
+    repeatUntilCheck = new QCheckBox("until");
+    repeatUntilEdit = new QDateEdit(QDate::currentDate().addMonths(3));
+    repeatUntilEdit->setCalendarPopup(true);
+    repeatUntilEdit->setEnabled(false);
+    connect(repeatUntilCheck, &QCheckBox::toggled, repeatUntilEdit, &QWidget::setEnabled);
+
+    QHBoxLayout* repeatLayout = new QHBoxLayout();
+    repeatLayout->addWidget(repeatCombo);
+    repeatLayout->addWidget(repeatIntervalSpin);
+    repeatLayout->addWidget(repeatUntilCheck);
+    repeatLayout->addWidget(repeatUntilEdit);
+
     inputLayout->addWidget(new QLabel("Title:"));
     inputLayout->addWidget(titleEdit);
     inputLayout->addWidget(new QLabel("Description:"));
@@ -235,6 +643,10 @@ void TaskManager::setupRightPanel()
     inputLayout->addWidget(dueDateEdit);
     inputLayout->addWidget(new QLabel("Priority:"));
     inputLayout->addWidget(priorityCombo);
+    inputLayout->addWidget(new QLabel("Tags:"));
+    inputLayout->addWidget(tagsEdit);
+    inputLayout->addWidget(new QLabel("Repeat:"));
+    inputLayout->addLayout(repeatLayout);
 
     // Buttons
     QHBoxLayout* buttonLayout1 = new QHBoxLayout();
@@ -245,11 +657,15 @@ void TaskManager::setupRightPanel()
     editButton = new QPushButton("Edit Task");
     updateButton = new QPushButton("Update Task");
     deleteButton = new QPushButton("Delete Task");
+    addBlockerButton = new QPushButton("Add Blocker...");
+    removeBlockerButton = new QPushButton("Remove Blocker...");
 
     editButton->setEnabled(false);
     updateButton->setEnabled(false);
     deleteButton->setEnabled(false);
     addSubtaskButton->setEnabled(false);
+    addBlockerButton->setEnabled(false);
+    removeBlockerButton->setEnabled(false);
 
     buttonLayout1->addWidget(addButton);
     buttonLayout1->addWidget(addSubtaskButton);
@@ -257,6 +673,10 @@ void TaskManager::setupRightPanel()
     buttonLayout2->addWidget(updateButton);
     buttonLayout2->addWidget(deleteButton);
 
+    QHBoxLayout* buttonLayout3 = new QHBoxLayout();
+    buttonLayout3->addWidget(addBlockerButton);
+    buttonLayout3->addWidget(removeBlockerButton);
+
     // Task details
     QGroupBox* detailsGroup = new QGroupBox("Task Details");
     QVBoxLayout* detailsLayout = new QVBoxLayout(detailsGroup);
@@ -268,22 +688,66 @@ void TaskManager::setupRightPanel()
 
     detailsLayout->addWidget(taskDetailsLabel);
 
+    // Statistics
+    QGroupBox* statsGroup = new QGroupBox("Statistics");
+    QVBoxLayout* statsLayout = new QVBoxLayout(statsGroup);
+
+    statsLabel = new QLabel();
+    statsLabel->setWordWrap(true);
+    statsLabel->setAlignment(Qt::AlignTop);
+
+    statsLayout->addWidget(statsLabel);
+
     rightLayout->addWidget(inputGroup);
     rightLayout->addLayout(buttonLayout1);
     rightLayout->addLayout(buttonLayout2);
+    rightLayout->addLayout(buttonLayout3);
     rightLayout->addWidget(detailsGroup);
+    rightLayout->addWidget(statsGroup);
     rightLayout->addStretch();
 }
 
+void TaskManager::setupMenus()
+{
+    QMenu* editMenu = menuBar()->addMenu("Edit");
+    undoAction = editMenu->addAction("&Undo", this, &TaskManager::undo);
+    undoAction->setShortcut(QKeySequence::Undo);
+    redoAction = editMenu->addAction("&Redo", this, &TaskManager::redo);
+    redoAction->setShortcut(QKeySequence::Redo);
+    updateUndoActions();
+
+    QMenu* tasksMenu = menuBar()->addMenu("Tasks");
+    tasksMenu->addAction("Show Critical Path", this, &TaskManager::showCriticalPath);
+    tasksMenu->addAction("Set Reminder Lead Time...", this, &TaskManager::setReminderLeadTime);
+
+    QMenu* archiveMenu = menuBar()->addMenu("Archive");
+    archiveMenu->addAction("Archive Completed Tasks", this, &TaskManager::archiveCompletedTasks);
+    archiveMenu->addAction("Restore Archived Task...", this, &TaskManager::restoreArchivedTask);
+    archiveMenu->addSeparator();
+    archiveMenu->addAction("Set Archive Age...", this, &TaskManager::setArchiveAge);
+}
+
 void TaskManager::connectSignals() {
     connect(addButton, &QPushButton::clicked, this, &TaskManager::addTask);
     connect(addSubtaskButton, &QPushButton::clicked, this, &TaskManager::addSubtask);
     connect(editButton, &QPushButton::clicked, this, &TaskManager::editTask);
     connect(updateButton, &QPushButton::clicked, this, &TaskManager::updateTask);
     connect(deleteButton, &QPushButton::clicked, this, &TaskManager::deleteTask);
+    connect(addBlockerButton, &QPushButton::clicked, this, &TaskManager::addBlocker);
+    connect(removeBlockerButton, &QPushButton::clicked, this, &TaskManager::removeBlocker);
     connect(taskTree, &QTreeWidget::currentItemChanged, this, &TaskManager::onTaskSelectionChanged);
     connect(taskTree, &TaskTreeWidget::taskToggled, this, &TaskManager::onTaskToggled);
+    connect(taskTree, &TaskTreeWidget::taskMoved, this, &TaskManager::onTaskMoved);
+    connect(agendaView, &AgendaView::taskSelected, this, &TaskManager::onAgendaTaskSelected);
+    connect(taskTree, &TaskTreeWidget::statisticsChanged, this, &TaskManager::updateStatistics);
+    connect(&saveWatcher, &QFutureWatcher<bool>::finished, this, &TaskManager::onSaveFinished);
+    connect(taskTree, &QTreeWidget::currentItemChanged, this, &TaskManager::updateStatistics);
     connect(filterCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &TaskManager::filterTasks);
+    connect(showAncestorsCheck, &QCheckBox::toggled, taskTree, &TaskTreeWidget::setShowAncestors);
+    connect(queryEdit, &QLineEdit::textChanged, this, &TaskManager::applyTagQuery);
+    connect(taskTree, &TaskTreeWidget::statisticsChanged, this, &TaskManager::updateTagCounts);
+    connect(history, &UndoHistory::changed, this, &TaskManager::updateUndoActions);
+    connect(taskTree, &TaskTreeWidget::tasksReset, history, &UndoHistory::clear);
 }
 
 void TaskManager::clearInputs() {
@@ -291,43 +755,259 @@ void TaskManager::clearInputs() {
     descEdit->clear();
     dueDateEdit->setDateTime(QDateTime::currentDateTime().addDays(1));
     priorityCombo->setCurrentText("Medium");
+    tagsEdit->clear();
+    repeatCombo->setCurrentIndex(Recurrence::Never);
+    repeatIntervalSpin->setValue(1);
+    repeatUntilCheck->setChecked(false);
 }
 
-void TaskManager::saveTasks() {
+Recurrence TaskManager::recurrenceFromInputs(const QDateTime& start) const {
+    QDate until = repeatUntilCheck->isChecked() ? repeatUntilEdit->date() : QDate();
+    return Recurrence(Recurrence::Frequency(repeatCombo->currentIndex()), repeatIntervalSpin->value(), start, until);
+}
+
+int TaskManager::archiveAgeDays() const {
+    QSettings settings(dataFilePath("settings.ini"), QSettings::IniFormat);
+    return settings.value("archive/ageDays", 30).toInt();
+}
+
+int TaskManager::archiveFinishedTasks() {
+    QDateTime cutoff = QDateTime::currentDateTime().addDays(-archiveAgeDays());
+
+    QList<TaskId> archived;
+    for (const TaskId& taskId : taskTree->getArchivableTaskIds(cutoff)) {
+        // Archive records are self-contained, so descriptions travel inline
+        QList<Task> subtree = taskTree->getSubtree(taskId);
+        for (Task& task : subtree) {
+            task.description = descriptions.text(task);
+            task.descriptionOffset = -1;
+            task.descriptionSize = 0;
+        }
+        if (archive.append(subtree)) {
+            archived.append(taskId);
+        }
+    }
+
+    if (!archived.isEmpty()) {
+        taskTree->removeTasks(archived);
+    }
+    return archived.size();
+}
+
+QString TaskManager::dataFilePath(const QString& fileName) const {
     QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     QDir().mkpath(dataDir);
-    QString filePath = dataDir + "/tasks_with_subtasks.json";
+    return dataDir + "/" + fileName;
+}
 
-    QJsonArray jsonArray;
-    for (const Task& task : taskTree->getAllTasks()) {
-        jsonArray.append(task.toJson());
+void TaskManager::saveTasks() {
+    // One write in flight at a time; later requests run after it with a fresh snapshot
+    if (saveWatcher.isRunning()) {
+        saveQueued = true;
+        return;
+    }
+
+    rotateJournal();
+    savingRestoredRoots += restoredRoots;
+    restoredRoots.clear();
+
+    // Serialize off the GUI thread from an O(1) snapshot while the tree keeps changing
+    // Main tasks go first and in board order, which loading takes as their order
+    TaskStore snapshot = taskTree->getSnapshot();
+    QList<TaskId> mainTaskIds = taskTree->getMainTaskIds();
+    QString filePath = dataFilePath("tasks_with_subtasks.json");
+    saveWatcher.setFuture(QtConcurrent::run([snapshot, mainTaskIds, filePath]() {
+        return writeTaskFile(filePath, [&snapshot, &mainTaskIds](const auto& write) {
+            for (const TaskId& mainTaskId : mainTaskIds) {
+                if (const Task* task = snapshot.find(mainTaskId)) {
+                    write(*task);
+                }
+            }
+            snapshot.forEach([&write](const Task& task) {
+                if (!task.isMainTask()) {
+                    write(task);
+                }
+            });
+        });
+    }));
+}
+
+void TaskManager::onSaveFinished() {
+    // The snapshot contains every delta journaled before it was taken
+    if (saveWatcher.result()) {
+        QFile::remove(dataFilePath("tasks_journal.pending"));
+        for (const TaskId& rootId : savingRestoredRoots) {
+            archive.retire(rootId);
+        }
+    } else {
+        restoredRoots += savingRestoredRoots;
     }
+    savingRestoredRoots.clear();
 
-    QJsonDocument doc(jsonArray);
-    QFile file(filePath);
-    if (file.open(QIODevice::WriteOnly)) {
-        file.write(doc.toJson());
+    if (saveQueued) {
+        saveQueued = false;
+        saveTasks();
     }
 }
 
-void TaskManager::loadTasks() {
-    QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QString filePath = dataDir + "/tasks_with_subtasks.json";
+void TaskManager::onRemoteChangesApplied() {
+    // Every instance saves what it converged to, so the file never keeps only one side
+    saveTasks();
+    onTaskSelectionChanged();
+}
+
+void TaskManager::writeSnapshot(const QList<Task>& tasks) {
+    saveWatcher.waitForFinished();
+    saveQueued = false;
+
+    bool written = writeTaskFile(dataFilePath("tasks_with_subtasks.json"), [&tasks](const auto& write) {
+        for (const Task& task : tasks) {
+            write(task);
+        }
+    });
+    if (written) {
+        // The snapshot now contains every journaled delta
+        QFile::remove(dataFilePath("tasks_journal.pending"));
+        QFile::remove(dataFilePath("tasks_journal.ndjson"));
+        for (const TaskId& rootId : savingRestoredRoots + restoredRoots) {
+            archive.retire(rootId);
+        }
+        savingRestoredRoots.clear();
+        restoredRoots.clear();
+    }
+}
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly)) {
+void TaskManager::rotateJournal() {
+    // Deltas journaled from now on belong to the next snapshot
+    QString journalPath = dataFilePath("tasks_journal.ndjson");
+    QString pendingPath = dataFilePath("tasks_journal.pending");
+    if (!QFile::exists(journalPath)) {
         return;
     }
+    if (!QFile::exists(pendingPath)) {
+        QFile::rename(journalPath, pendingPath);
+        return;
+    }
+
+    // An earlier save did not finish; keep its deltas as well
+    QFile journal(journalPath);
+    QFile pending(pendingPath);
+    if (journal.open(QIODevice::ReadOnly) && pending.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        pending.write(journal.readAll());
+        journal.remove();
+    }
+}
 
-    QByteArray data = file.readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    QJsonArray jsonArray = doc.array();
+void TaskManager::loadTasks() {
+    archive.open(dataFilePath("tasks_archive.dat"));
+    descriptions.open(dataFilePath("task_descriptions.blob"));
+
+    TaskFileReader reader;
+    if (!reader.open(dataFilePath("tasks_with_subtasks.json"))) {
+        return;
+    }
 
     QList<Task> tasks;
-    for (const QJsonValue& value : jsonArray) {
-        tasks.append(Task::fromJson(value.toObject()));
+    Task task;
+    while (reader.next(task)) {
+        tasks.append(task);
+    }
+
+    taskTree->setAllTasks(tasks);
+    replayJournal();
+    migrateDescriptions();
+
+    // A tree on the board is live: it was archived but the board not saved after,
+    // or restored and saved but not yet retired from the archive
+    for (const TaskArchive::Entry& entry : archive.entries()) {
+        if (taskTree->getStore().contains(entry.rootId)) {
+            archive.retire(entry.rootId);
+        }
+    }
+
+    // Keep only active work in memory
+    if (archiveFinishedTasks() > 0) {
+        saveTasks();
+    }
+}
+
+void TaskManager::migrateDescriptions() {
+    QList<Task> tasks = taskTree->getAllTasks();
+
+    qint64 liveBytes = 0;
+    bool hasInline = false;
+    for (const Task& task : tasks) {
+        if (task.hasStoredDescription()) {
+            liveBytes += task.descriptionSize;
+        } else if (!task.description.isEmpty()) {
+            hasInline = true;
+        }
     }
 
+    // Edits only ever append, so rewrite the blob once it is mostly dead text.
+    // Other windows on the same file read it by offset, so only one alone may.
+    bool compact = descriptions.fileSize() > 2 * liveBytes + 64 * 1024
+                   && !SyncPeer::isInUse(dataFilePath("tasks_with_subtasks.json"));
+    if (!hasInline && !compact) {
+        return;
+    }
+
+    if (compact) {
+        // Save everything inline first so a crash while rewriting loses nothing
+        for (Task& task : tasks) {
+            task.description = descriptions.text(task);
+            task.descriptionOffset = -1;
+            task.descriptionSize = 0;
+        }
+        writeSnapshot(tasks);
+        descriptions.clear();
+    }
+
+    for (Task& task : tasks) {
+        if (!task.description.isEmpty()) {
+            descriptions.store(task, task.description);
+        }
+    }
     taskTree->setAllTasks(tasks);
+    saveTasks();
+}
+
+void TaskManager::appendDelta(const QJsonObject& delta) {
+    QFile journal(dataFilePath("tasks_journal.ndjson"));
+    if (journal.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        journal.write(QJsonDocument(delta).toJson(QJsonDocument::Compact));
+        journal.write("\n");
+    }
+}
+
+void TaskManager::replayJournal() {
+    // Replaying must not journal the same deltas again
+    taskTree->blockSignals(true);
+    bool replayed = false;
+
+    const QStringList journalFiles = {"tasks_journal.pending", "tasks_journal.ndjson"};
+    for (const QString& fileName : journalFiles) {
+        QFile journal(dataFilePath(fileName));
+        if (!journal.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+
+        while (!journal.atEnd()) {
+            QJsonObject delta = QJsonDocument::fromJson(journal.readLine()).object();
+            if (delta["op"].toString() == "move") {
+                taskTree->moveTask(TaskId::fromString(delta["id"].toString()),
+                                   TaskId::fromString(delta["parentId"].toString()),
+                                   delta["index"].toInt(-1));
+                replayed = true;
+            }
+        }
+    }
+    taskTree->blockSignals(false);
+
+    // Fold the journal into the snapshot
+    if (replayed) {
+        agendaView->reload(); // Roll-ups during the replay were not signalled
+        saveTasks();
+    }
 }
 
@@ -4,8 +4,15 @@
 #include <QMainWindow>
 #include <QtWidgets>
 #include <QSplitter>
+#include <QFutureWatcher>
 
 #include "tasktreewidget.h"
+#include "agendaview.h"
+#include "taskarchive.h"
+#include "descriptionstore.h"
+#include "syncpeer.h"
+#include "reminderscheduler.h"
+#include "undohistory.h"
 
 class TaskManager : public QMainWindow
 {
@@ -21,19 +28,42 @@ private slots:
     void editTask();
     void updateTask();
     void deleteTask();
+    void addBlocker();
+    void removeBlocker();
+    void showCriticalPath();
     void onTaskSelectionChanged();
-    void onTaskToggled(const QString& taskId);
+    void onTaskToggled(const TaskId& taskId);
+    void undo();
+    void redo();
+    void updateUndoActions();
+    void onTaskMoved(const TaskId& taskId, const TaskId& newParentId, int index);
+    void onAgendaTaskSelected(const TaskId& taskId);
     void filterTasks();
+    void archiveCompletedTasks();
+    void restoreArchivedTask();
+    void setArchiveAge();
+    void updateStatistics();
+    void onSaveFinished();
+    void onRemoteChangesApplied();
+    void onReminder(const TaskId& taskId, ReminderScheduler::Kind kind);
+    void setReminderLeadTime();
+    void applyTagQuery();
+    void updateTagCounts();
 
 
 private:
     QWidget* centralWidget;
     QSplitter* mainSplitter;
 
-    // Left panel - Task tree
+    // Left panel - Task tree and agenda
     QWidget* leftPanel;
+    QTabWidget* viewTabs;
     TaskTreeWidget* taskTree;
+    AgendaView* agendaView;
     QComboBox* filterCombo;
+    QCheckBox* showAncestorsCheck;
+    QLineEdit* queryEdit;
+    QLabel* tagCountsLabel;
 
     // Right panel - Task input and details
     QWidget* rightPanel;
@@ -41,21 +71,50 @@ private:
     QTextEdit* descEdit;
     QDateTimeEdit* dueDateEdit;
     QComboBox* priorityCombo;
+    QLineEdit* tagsEdit;
+    QComboBox* repeatCombo;
+    QSpinBox* repeatIntervalSpin;
+    QCheckBox* repeatUntilCheck;
+    QDateEdit* repeatUntilEdit;
     QPushButton* addButton;
     QPushButton* addSubtaskButton;
     QPushButton* editButton;
     QPushButton* updateButton;
     QPushButton* deleteButton;
+    QPushButton* addBlockerButton;
+    QPushButton* removeBlockerButton;
     QLabel* taskDetailsLabel;
+    QLabel* statsLabel;
 
-    QString currentEditId;
+    TaskId currentEditId;
+    TaskArchive archive;
+    DescriptionStore descriptions;
+    QFutureWatcher<bool> saveWatcher;
+    bool saveQueued = false;
+    QList<TaskId> restoredRoots;       // Leave the archive once a save that holds them succeeds
+    QList<TaskId> savingRestoredRoots; // Restored before the save in flight started
+    SyncPeer* syncPeer;
+    ReminderScheduler* reminders;
+    UndoHistory* history;
+    QAction* undoAction;
+    QAction* redoAction;
 
     void setupUI();
     void setupLeftPanel();
     void setupRightPanel();
+    void setupMenus();
     void connectSignals();
     void clearInputs();
+    Recurrence recurrenceFromInputs(const QDateTime& start) const;
     void saveTasks();
+    void writeSnapshot(const QList<Task>& tasks);
+    void rotateJournal();
     void loadTasks();
+    void migrateDescriptions();
+    void appendDelta(const QJsonObject& delta);
+    void replayJournal();
+    QString dataFilePath(const QString& fileName) const;
+    int archiveAgeDays() const;
+    int archiveFinishedTasks();
 };
 #endif // TASKMANAGER_H
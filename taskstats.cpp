@@ -0,0 +1,107 @@
+#include "taskstats.h"
+
+void TaskStats::clear(const QDate& date)
+{
+    today = date;
+    total = 0;
+    completed = 0;
+    priorityCounts.clear();
+    for (int& bucketCount : dueCounts) {
+        bucketCount = 0;
+    }
+    rootProgressMap.clear();
+}
+
+void TaskStats::addTask(const Task& task, const TaskId& rootId)
+{
+    count(task, rootId, 1);
+}
+
+void TaskStats::removeTask(const Task& task, const TaskId& rootId)
+{
+    count(task, rootId, -1);
+}
+
+void TaskStats::updateTask(const Task& before, const Task& after, const TaskId& rootId)
+{
+    count(before, rootId, -1);
+    count(after, rootId, 1);
+}
+
+void TaskStats::merge(const TaskStats& other)
+{
+    total += other.total;
+    completed += other.completed;
+    for (auto it = other.priorityCounts.constBegin(); it != other.priorityCounts.constEnd(); ++it) {
+        priorityCounts[it.key()] += it.value();
+    }
+    for (int bucket = 0; bucket < DueBucketCount; ++bucket) {
+        dueCounts[bucket] += other.dueCounts[bucket];
+    }
+    for (auto it = other.rootProgressMap.constBegin(); it != other.rootProgressMap.constEnd(); ++it) {
+        Progress& progress = rootProgressMap[it.key()];
+        progress.total += it.value().total;
+        progress.completed += it.value().completed;
+    }
+}
+
+QDate TaskStats::referenceDate() const { return today; }
+int TaskStats::totalCount() const { return total; }
+int TaskStats::completedCount() const { return completed; }
+int TaskStats::pendingCount() const { return total - completed; }
+
+int TaskStats::completionPercent() const
+{
+    return total > 0 ? (completed * 100) / total : 0;
+}
+
+int TaskStats::priorityCount(const QString& priority) const
+{
+    return priorityCounts.value(priority, 0);
+}
+
+int TaskStats::dueCount(DueBucket bucket) const
+{
+    return dueCounts[bucket];
+}
+
+TaskStats::Progress TaskStats::rootProgress(const TaskId& rootId) const
+{
+    return rootProgressMap.value(rootId);
+}
+
+TaskStats::DueBucket TaskStats::dueBucket(const Task& task) const
+{
+    if (task.completed || !task.dueDate.isValid()) return NoDueBucket;
+
+    qint64 days = today.daysTo(task.dueDate.date());
+    if (days < 0) return Overdue;
+    if (days == 0) return DueToday;
+    if (days < 7) return DueThisWeek;
+    return NoDueBucket;
+}
+
+void TaskStats::count(const Task& task, const TaskId& rootId, int delta)
+{
+    total += delta;
+    if (task.completed) {
+        completed += delta;
+    }
+
+    int& priorityCount = priorityCounts[task.priority];
+    priorityCount += delta;
+    if (priorityCount == 0) {
+        priorityCounts.remove(task.priority);
+    }
+
+    dueCounts[dueBucket(task)] += delta;
+
+    Progress& progress = rootProgressMap[rootId];
+    progress.total += delta;
+    if (task.completed) {
+        progress.completed += delta;
+    }
+    if (progress.total == 0) {
+        rootProgressMap.remove(rootId);
+    }
+}
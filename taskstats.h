@@ -0,0 +1,49 @@
+#ifndef TASKSTATS_H
+#define TASKSTATS_H
+#include <QString>
+#include <QDate>
+#include <QHash>
+#include "task.h"
+
+// Aggregate counters kept up to date by the code that mutates tasks, so reading
+// them never needs a scan. Due buckets are relative to referenceDate() and only
+// count pending tasks; callers recount once the date rolls over.
+class TaskStats
+{
+public:
+    enum DueBucket { NoDueBucket, Overdue, DueToday, DueThisWeek, DueBucketCount };
+
+    struct Progress {
+        int total = 0;
+        int completed = 0;
+        int percent() const { return total > 0 ? (completed * 100) / total : 0; }
+    };
+
+    void clear(const QDate& today = QDate::currentDate());
+    void addTask(const Task& task, const TaskId& rootId);
+    void removeTask(const Task& task, const TaskId& rootId);
+    void updateTask(const Task& before, const Task& after, const TaskId& rootId);
+    void merge(const TaskStats& other); // Counts from a disjoint set of tasks, same reference date
+
+    QDate referenceDate() const;
+    int totalCount() const;
+    int completedCount() const;
+    int pendingCount() const;
+    int completionPercent() const;
+    int priorityCount(const QString& priority) const;
+    int dueCount(DueBucket bucket) const;
+    Progress rootProgress(const TaskId& rootId) const;
+
+private:
+    QDate today = QDate::currentDate();
+    int total = 0;
+    int completed = 0;
+    QHash<QString, int> priorityCounts;
+    int dueCounts[DueBucketCount] = {};
+    QHash<TaskId, Progress> rootProgressMap; // Whole tree under each main task, root included
+
+    DueBucket dueBucket(const Task& task) const;
+    void count(const Task& task, const TaskId& rootId, int delta);
+};
+
+#endif // TASKSTATS_H
@@ -0,0 +1,235 @@
+#include "taskstore.h"
+#include <QtAlgorithms>
+
+namespace {
+
+const int BitsPerLevel = 5;
+
+quint32 slotBit(size_t hash, int shift)
+{
+    if (shift >= int(sizeof(size_t) * 8)) return 1u;
+    return 1u << ((hash >> shift) & 31);
+}
+
+int slotIndex(quint32 bitmap, quint32 bit)
+{
+    return qPopulationCount(bitmap & (bit - 1));
+}
+
+size_t hashOf(const TaskId& id)
+{
+    // Ids are random, so their bits are already evenly spread
+    return size_t(id.highBits() ^ id.lowBits());
+}
+
+}
+
+TaskStore::TaskStore()
+    : root(makeNode()) {}
+
+bool TaskStore::contains(const TaskId& id) const
+{
+    return find(id) != nullptr;
+}
+
+const Task* TaskStore::find(const TaskId& id) const
+{
+    size_t hash = hashOf(id);
+    const Node* node = root.get();
+    int shift = 0;
+
+    while (node) {
+        if (!node->entries.empty()) {
+            for (const Task& task : node->entries) {
+                if (task.id == id) return &task;
+            }
+            return nullptr;
+        }
+
+        quint32 bit = slotBit(hash, shift);
+        if (!(node->bitmap & bit)) return nullptr;
+        node = node->children[slotIndex(node->bitmap, bit)].get();
+        shift += BitsPerLevel;
+    }
+    return nullptr;
+}
+
+Task TaskStore::value(const TaskId& id, const Task& defaultValue) const
+{
+    const Task* task = find(id);
+    return task ? *task : defaultValue;
+}
+
+const Task& TaskStore::operator[](const TaskId& id) const
+{
+    static const Task missing;
+    const Task* task = find(id);
+    return task ? *task : missing;
+}
+
+Task& TaskStore::operator[](const TaskId& id)
+{
+    Task* task = findMutable(id);
+    if (!task) {
+        Task newTask;
+        newTask.id = id;
+        insert(newTask);
+        task = findMutable(id);
+    }
+    return *task;
+}
+
+void TaskStore::insert(const Task& task)
+{
+    if (insert(root, task, hashOf(task.id), 0)) {
+        count++;
+    }
+}
+
+bool TaskStore::remove(const TaskId& id)
+{
+    // Check first so a miss does not copy shared nodes
+    if (!contains(id)) return false;
+
+    remove(root, id, hashOf(id), 0);
+    count--;
+    return true;
+}
+
+void TaskStore::clear()
+{
+    root = makeNode();
+    count = 0;
+
+    // Hand whole slabs back if no other store still holds nodes
+    SlabPool::shared().trim();
+}
+
+int TaskStore::size() const { return count; }
+bool TaskStore::isEmpty() const { return count == 0; }
+int TaskStore::shardCount() const { return int(root->children.size()); }
+
+QList<Task> TaskStore::values() const
+{
+    QList<Task> tasks;
+    tasks.reserve(count);
+    forEach([&tasks](const Task& task) { tasks.append(task); });
+    return tasks;
+}
+
+TaskStore TaskStore::snapshot() const
+{
+    return *this;
+}
+
+std::shared_ptr<TaskStore::Node> TaskStore::makeNode()
+{
+    return std::allocate_shared<Node>(SlabAllocator<Node>());
+}
+
+std::shared_ptr<TaskStore::Node> TaskStore::makeNode(const Node& other)
+{
+    return std::allocate_shared<Node>(SlabAllocator<Node>(), other);
+}
+
+TaskStore::Node* TaskStore::detach(std::shared_ptr<Node>& node)
+{
+    // Nodes still reachable from another store are copied, never written
+    if (node.use_count() != 1) {
+        node = makeNode(*node);
+    }
+    return node.get();
+}
+
+Task* TaskStore::findMutable(const TaskId& id)
+{
+    if (!contains(id)) return nullptr;
+
+    size_t hash = hashOf(id);
+    std::shared_ptr<Node>* slot = &root;
+    int shift = 0;
+
+    while (true) {
+        Node* node = detach(*slot);
+        if (!node->entries.empty()) {
+            for (Task& task : node->entries) {
+                if (task.id == id) return &task;
+            }
+            return nullptr;
+        }
+
+        quint32 bit = slotBit(hash, shift);
+        slot = &node->children[slotIndex(node->bitmap, bit)];
+        shift += BitsPerLevel;
+    }
+}
+
+bool TaskStore::insert(std::shared_ptr<Node>& slot, const Task& task, size_t hash, int shift)
+{
+    if (!slot->entries.empty() && slot->hash != hash) {
+        // Two different hashes meet in one leaf: push the leaf one level down
+        std::shared_ptr<Node> branch = makeNode();
+        branch->bitmap = slotBit(slot->hash, shift);
+        branch->children.push_back(slot);
+        slot = branch;
+    }
+
+    Node* node = detach(slot);
+    if (!node->entries.empty()) {
+        for (Task& entry : node->entries) {
+            if (entry.id == task.id) {
+                entry = task;
+                return false;
+            }
+        }
+        node->entries.push_back(task);
+        return true;
+    }
+
+    quint32 bit = slotBit(hash, shift);
+    int index = slotIndex(node->bitmap, bit);
+    if (!(node->bitmap & bit)) {
+        std::shared_ptr<Node> leaf = makeNode();
+        leaf->hash = hash;
+        leaf->entries.push_back(task);
+        node->children.insert(node->children.begin() + index, leaf);
+        node->bitmap |= bit;
+        return true;
+    }
+    return insert(node->children[index], task, hash, shift + BitsPerLevel);
+}
+
+void TaskStore::remove(std::shared_ptr<Node>& slot, const TaskId& id, size_t hash, int shift)
+{
+    Node* node = detach(slot);
+    if (!node->entries.empty()) {
+        for (auto it = node->entries.begin(); it != node->entries.end(); ++it) {
+            if (it->id == id) {
+                node->entries.erase(it);
+                break;
+            }
+        }
+        if (node->entries.empty()) {
+            slot.reset();
+        }
+        return;
+    }
+
+    quint32 bit = slotBit(hash, shift);
+    int index = slotIndex(node->bitmap, bit);
+    remove(node->children[index], id, hash, shift + BitsPerLevel);
+    if (!node->children[index]) {
+        node->children.erase(node->children.begin() + index);
+        node->bitmap &= ~bit;
+    }
+
+    if (shift == 0) return; // The root stays a branch
+
+    // Pull a lone leaf up so lookups stay short
+    if (node->children.empty()) {
+        slot.reset();
+    } else if (node->children.size() == 1 && !node->children.front()->entries.empty()) {
+        std::shared_ptr<Node> leaf = node->children.front();
+        slot = leaf;
+    }
+}
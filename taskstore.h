@@ -0,0 +1,75 @@
+#ifndef TASKSTORE_H
+#define TASKSTORE_H
+#include <QString>
+#include <QList>
+#include <memory>
+#include <vector>
+#include "task.h"
+#include "slabpool.h"
+
+// Tasks keyed by id in a persistent hash array mapped trie. Copying a store is
+// O(1) and shares every node; a write copies only the nodes on its path that are
+// still shared, so a copy taken with snapshot() stays immutable and can be read
+// from another thread while this one keeps mutating. Nodes, their child arrays
+// and the task records are allocated from SlabPool, so building or dropping a
+// large store costs one allocation per slab rather than several per task.
+class TaskStore
+{
+public:
+    TaskStore();
+
+    bool contains(const TaskId& id) const;
+    const Task* find(const TaskId& id) const;
+    Task value(const TaskId& id, const Task& defaultValue = Task()) const;
+    const Task& operator[](const TaskId& id) const;
+    Task& operator[](const TaskId& id);
+    void insert(const Task& task);
+    bool remove(const TaskId& id);
+    void clear();
+    int size() const;
+    bool isEmpty() const;
+    QList<Task> values() const;
+    TaskStore snapshot() const;
+
+    template<typename Function>
+    void forEach(Function function) const { forEach(root.get(), function); }
+
+    // The root's branches, so a scan can be split into disjoint parts
+    int shardCount() const;
+    template<typename Function>
+    void forEachInShard(int shard, Function function) const { forEach(root->children[shard].get(), function); }
+
+private:
+    template<typename T>
+    using SlabVector = std::vector<T, SlabAllocator<T>>;
+
+    struct Node {
+        quint32 bitmap = 0;                         // Branch: occupied slots
+        SlabVector<std::shared_ptr<Node>> children; // Branch: one child per set bit
+        SlabVector<Task> entries;                   // Leaf: tasks sharing one full hash
+        size_t hash = 0;                            // Leaf: that hash
+    };
+
+    std::shared_ptr<Node> root; // Always a branch
+    int count = 0;
+
+    static std::shared_ptr<Node> makeNode();
+    static std::shared_ptr<Node> makeNode(const Node& other);
+    static Node* detach(std::shared_ptr<Node>& node);
+    Task* findMutable(const TaskId& id);
+    static bool insert(std::shared_ptr<Node>& slot, const Task& task, size_t hash, int shift);
+    static void remove(std::shared_ptr<Node>& slot, const TaskId& id, size_t hash, int shift);
+
+    template<typename Function>
+    static void forEach(const Node* node, Function& function)
+    {
+        for (const Task& task : node->entries) {
+            function(task);
+        }
+        for (const std::shared_ptr<Node>& child : node->children) {
+            forEach(child.get(), function);
+        }
+    }
+};
+
+#endif // TASKSTORE_H
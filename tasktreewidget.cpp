@@ -1,6 +1,15 @@
 #include "tasktreewidget.h"
+#include "stringpool.h"
 #include <QHeaderView>
 #include <QTimer>
+#include <QDropEvent>
+
+namespace {
+
+// Below this many tasks a filter pass is quicker on the GUI thread than handing it off
+const int ParallelScanThreshold = 50000;
+
+}
 
 bool TaskTreeWidget::isUpdating = false;
 TaskTreeWidget::TaskTreeWidget()
@@ -13,47 +22,131 @@ TaskTreeWidget::TaskTreeWidget()
     header()->setSectionResizeMode(3, QHeaderView::ResizeToContents);
     setRootIsDecorated(true);
     setIndentation(20);
+
+    // Rows can be dragged onto another task to reparent them
+    setSelectionMode(QAbstractItemView::SingleSelection);
+    setDragDropMode(QAbstractItemView::InternalMove);
+    setDefaultDropAction(Qt::MoveAction);
+    setDropIndicatorShown(true);
+
+    connect(&filterWatcher, &QFutureWatcher<ParallelScan::Matches>::finished,
+            this, &TaskTreeWidget::onFilterPassFinished);
+}
+
+TaskTreeWidget::~TaskTreeWidget()
+{
+    filterWatcher.cancel();
+    filterWatcher.waitForFinished();
 }
 
-void TaskTreeWidget::addTask(const Task& task)
+void TaskTreeWidget::addTask(const Task& newTask)
 {
-    taskMap[task.id] = task;
+    // Ids are minted here, on insert, rather than for every Task value
+    Task task = newTask;
+    if (task.id.isNull()) {
+        task.id = TaskId::create();
+    }
+    taskMap.insert(task);
 
     if (task.isMainTask()) {
         mainTaskIds.append(task.id);
     } else {
         // Add to parent's subtask list
         if (taskMap.contains(task.parentId)) {
-            if (!taskMap[task.parentId].subtaskIds.contains(task.id)) {
+            if (!getStore()[task.parentId].subtaskIds.contains(task.id)) {
                 taskMap[task.parentId].subtaskIds.append(task.id);
             }
         }
     }
+    stats.addTask(task, getRootTaskId(task.id));
+    tagIndex.addTask(task);
+    dropRejectedBlockers(dependencies.addTask(task));
+    columns.addTask(task);
     applyCurrentFilter();
+    emit tasksAdded({task.id});
+    emit statisticsChanged();
 }
 
-void TaskTreeWidget::removeTask(const QString& taskId)
+void TaskTreeWidget::addTasks(const QList<Task>& tasks)
 {
-    if (!taskMap.contains(taskId)) return;
+    for (const Task& task : tasks) {
+        taskMap.insert(task);
+    }
 
-    Task task = taskMap[taskId];
+    for (const Task& task : tasks) {
+        if (task.isMainTask()) {
+            if (!mainTaskIds.contains(task.id)) {
+                mainTaskIds.append(task.id);
+            }
+        } else if (taskMap.contains(task.parentId)) {
+            if (!getStore()[task.parentId].subtaskIds.contains(task.id)) {
+                taskMap[task.parentId].subtaskIds.append(task.id);
+            }
+        }
+    }
 
+    for (const Task& task : tasks) {
+        stats.addTask(task, getRootTaskId(task.id));
+        tagIndex.addTask(task);
+        columns.addTask(task);
+    }
+    dropRejectedBlockers(dependencies.addTasks(tasks));
+    applyCurrentFilter();
+
+    QList<TaskId> addedIds;
+    addedIds.reserve(tasks.size());
+    for (const Task& task : tasks) {
+        addedIds.append(task.id);
+    }
+    emit tasksAdded(addedIds);
+    emit statisticsChanged();
+}
+
+void TaskTreeWidget::removeTask(const TaskId& taskId)
+{
+    removeTasks({taskId});
+}
+
+void TaskTreeWidget::removeTasks(const QList<TaskId>& taskIds)
+{
     // Remove all subtasks recursively
-    QList<QString> toRemove = {taskId};
+    QList<TaskId> toRemove = taskIds;
     for (int i = 0; i < toRemove.size(); ++i)
     {
-        QString currentId = toRemove[i];
+        TaskId currentId = toRemove[i];
         if (taskMap.contains(currentId)) {
-            toRemove.append(taskMap[currentId].subtaskIds);
+            toRemove.append(getStore()[currentId].subtaskIds);
+        }
+    }
+
+    // Resolve roots while the parent links are still intact
+    QHash<TaskId, TaskId> rootIds;
+    for (const TaskId& id : toRemove) {
+        if (taskMap.contains(id) && !rootIds.contains(id)) {
+            rootIds[id] = getRootTaskId(id);
         }
     }
 
-    for (const QString& id : toRemove)
+    QList<TaskId> removedIds;
+    for (const TaskId& id : toRemove)
     {
         if (taskMap.contains(id)) {
-            Task t = taskMap[id];
+            removedIds.append(id);
+            Task t = getStore()[id];
+            stats.removeTask(t, rootIds.value(id));
+            tagIndex.removeTask(t);
+            columns.removeTask(id);
+
+            // Tasks it was blocking are no longer waiting for it
+            for (const TaskId& dependentId : dependencies.dependents(id)) {
+                if (taskMap.contains(dependentId)) {
+                    taskMap[dependentId].blockedBy.removeAll(id);
+                }
+            }
+            dependencies.removeTask(id);
+
             // Remove from parent's subtask list
-            if (!t.parentId.isEmpty() && taskMap.contains(t.parentId)) {
+            if (!t.parentId.isNull() && taskMap.contains(t.parentId)) {
                 taskMap[t.parentId].subtaskIds.removeOne(id);
             }
             // Remove from main task list if it's a main task
@@ -63,24 +156,53 @@ void TaskTreeWidget::removeTask(const QString& taskId)
     }
 
     applyCurrentFilter();
+    emit tasksRemoved(removedIds);
+    emit statisticsChanged();
 }
 
-void TaskTreeWidget::updateTask(const QString& taskId, const Task& newTask)
+void TaskTreeWidget::updateTask(const TaskId& taskId, const Task& newTask)
 {
     if (taskMap.contains(taskId)) {
+        const Task before = getStore()[taskId];
         Task updatedTask = newTask;
         updatedTask.id = taskId;
-        updatedTask.subtaskIds = taskMap[taskId].subtaskIds; // Preserve subtasks
-        updatedTask.parentId = taskMap[taskId].parentId; // Preserve parent
-        taskMap[taskId] = updatedTask;
-        applyCurrentFilter();
+        updatedTask.subtaskIds = before.subtaskIds; // Preserve subtasks
+        updatedTask.parentId = before.parentId; // Preserve parent
+        updatedTask.blockedBy = before.blockedBy; // Preserve dependencies
+        stats.updateTask(before, updatedTask, getRootTaskId(taskId));
+        tagIndex.updateTask(before, updatedTask);
+        dependencies.updateTask(updatedTask);
+        columns.updateTask(updatedTask);
+        taskMap.insert(updatedTask);
+
+        // A shown row that still matches is only repainted. Completion also shows in
+        // the parent's progress and decides whether dependents are ready, so it refilters.
+        QTreeWidgetItem* item = itemMap.value(taskId);
+        bool rowOnly = item && batchDepth == 0 && !showAncestors && !filterWatcher.isRunning()
+                       && before.completed == updatedTask.completed
+                       && (appliedQuery.isEmpty() || before.tags == updatedTask.tags)
+                       && ParallelScan::matchesFilter(updatedTask, currentFilter, dependencies);
+        if (rowOnly) {
+            blockSignals(true);
+            updateTaskAppearance(item, updatedTask);
+            blockSignals(false);
+        } else {
+            applyCurrentFilter();
+        }
+        emit taskChanged(taskId);
+        emit statisticsChanged();
     }
 }
 
 Task TaskTreeWidget::getTask(QTreeWidgetItem* item) const
 {
     if (!item) return Task();
-    QString taskId = item->data(0, Qt::UserRole).toString();
+    TaskId taskId = item->data(0, Qt::UserRole).value<TaskId>();
+    return taskMap.value(taskId, Task());
+}
+
+Task TaskTreeWidget::getTaskById(const TaskId& taskId) const
+{
     return taskMap.value(taskId, Task());
 }
 
@@ -90,20 +212,54 @@ Task TaskTreeWidget::getSelectedTask() const
     return getTask(item);
 }
 
-QString TaskTreeWidget::getSelectedTaskId() const
+TaskId TaskTreeWidget::getSelectedTaskId() const
 {
     QTreeWidgetItem* item = currentItem();
-    if (!item) return QString();
-    return item->data(0, Qt::UserRole).toString();
+    if (!item) return TaskId();
+    return item->data(0, Qt::UserRole).value<TaskId>();
 }
 
-void TaskTreeWidget::addSubtask(const QString& parentId, const Task& subtask)
+bool TaskTreeWidget::selectTask(const TaskId& taskId)
+{
+    QTreeWidgetItem* item = itemMap.value(taskId);
+    if (!item) return false;
+
+    setCurrentItem(item);
+    scrollToItem(item);
+    return true;
+}
+
+void TaskTreeWidget::setTaskCompleted(const TaskId& taskId, bool completed)
+{
+    if (!taskMap.contains(taskId) || getStore()[taskId].completed == completed) return;
+
+    // A shown row goes through the same path as clicking its checkbox
+    if (QTreeWidgetItem* item = itemMap.value(taskId)) {
+        item->setCheckState(3, completed ? Qt::Checked : Qt::Unchecked);
+        return;
+    }
+
+    Task before = getStore()[taskId];
+    taskMap[taskId].setCompleted(completed);
+    stats.updateTask(before, getStore()[taskId], getRootTaskId(taskId));
+    tagIndex.updateTask(before, getStore()[taskId]);
+    dependencies.updateTask(getStore()[taskId]);
+    columns.updateTask(getStore()[taskId]);
+    emit taskChanged(taskId);
+
+    updateParentCompletion(taskId);
+    applyCurrentFilter();
+    emit statisticsChanged();
+    emit taskToggled(taskId);
+}
+
+void TaskTreeWidget::addSubtask(const TaskId& parentId, const Task& subtask)
 {
     if (!taskMap.contains(parentId)) return;
 
     Task newSubtask = subtask;
     newSubtask.parentId = parentId;
-    newSubtask.level = taskMap[parentId].level + 1;
+    newSubtask.level = getStore()[parentId].level + 1;
     addTask(newSubtask);
 }
 
@@ -114,32 +270,86 @@ bool TaskTreeWidget::canAddSubtask() const
 
 QList<Task> TaskTreeWidget::getAllTasks() const
 {
-    return taskMap.values();
+    // The store has no order of its own; setAllTasks() takes the main task order from the list
+    QList<Task> tasks;
+    tasks.reserve(taskMap.size());
+    for (const TaskId& mainTaskId : mainTaskIds) {
+        if (const Task* task = taskMap.find(mainTaskId)) {
+            tasks.append(*task);
+        }
+    }
+    taskMap.forEach([&tasks](const Task& task) {
+        if (!task.isMainTask()) {
+            tasks.append(task);
+        }
+    });
+    return tasks;
+}
+
+QList<TaskId> TaskTreeWidget::getMainTaskIds() const
+{
+    return mainTaskIds;
+}
+
+const TaskStore& TaskTreeWidget::getStore() const
+{
+    return taskMap;
+}
+
+TaskStore TaskTreeWidget::getSnapshot() const
+{
+    return taskMap.snapshot();
 }
 
 void TaskTreeWidget::setAllTasks(const QList<Task>& tasks)
 {
     taskMap.clear();
     mainTaskIds.clear();
+    StringPool::shared().purge(); // Tags only the old tasks used
 
     // First pass: add all tasks to map
     for (const Task& task : tasks) {
-        taskMap[task.id] = task;
+        taskMap.insert(task);
         if (task.isMainTask()) {
             mainTaskIds.append(task.id);
         }
     }
 
-    // Second pass: rebuild parent-child relationships
+    // Second pass: rebuild parent-child relationships. Files written by other
+    // tools may name a parent that is not there, or carry no usable levels.
+    bool levelsStale = false;
     for (const Task& task : tasks) {
-        if (!task.parentId.isEmpty() && taskMap.contains(task.parentId)) {
-            if (!taskMap[task.parentId].subtaskIds.contains(task.id)) {
+        if (task.parentId.isNull()) {
+            levelsStale |= task.level != 0;
+        } else if (const Task* parent = taskMap.find(task.parentId)) {
+            levelsStale |= task.level != parent->level + 1;
+            if (!parent->subtaskIds.contains(task.id)) {
                 taskMap[task.parentId].subtaskIds.append(task.id);
             }
+        } else {
+            taskMap[task.id].parentId = TaskId();
+            mainTaskIds.append(task.id);
+            levelsStale = true;
+        }
+    }
+    if (levelsStale) {
+        for (const TaskId& mainTaskId : mainTaskIds) {
+            updateSubtreeLevels(mainTaskId);
         }
     }
 
+    rebuildStats();
+    tagIndex.clear();
+    columns.clear();
+    taskMap.forEach([this](const Task& task) {
+        tagIndex.addTask(task);
+        columns.addTask(task);
+    });
+    dependencies.clear();
+    dropRejectedBlockers(dependencies.addTasks(taskMap.values()));
     applyCurrentFilter();
+    emit tasksReset();
+    emit statisticsChanged();
 }
 
 void TaskTreeWidget::applyFilter(const QString& filterType)
@@ -148,11 +358,11 @@ void TaskTreeWidget::applyFilter(const QString& filterType)
     applyCurrentFilter();
 }
 
-int TaskTreeWidget::getTaskProgress(const QString& taskId) const
+int TaskTreeWidget::getTaskProgress(const TaskId& taskId) const
 {
     if (!taskMap.contains(taskId)) return 0;
 
-    const Task& task = taskMap[taskId];
+    const Task& task = getStore()[taskId];
     if (!task.hasSubtasks()) {
         return task.completed ? 100 : 0;
     }
@@ -160,8 +370,8 @@ int TaskTreeWidget::getTaskProgress(const QString& taskId) const
     int completed = 0;
     int total = task.subtaskIds.size();
 
-    for (const QString& subtaskId : task.subtaskIds) {
-        if (taskMap.contains(subtaskId) && taskMap[subtaskId].completed) {
+    for (const TaskId& subtaskId : task.subtaskIds) {
+        if (taskMap.contains(subtaskId) && getStore()[subtaskId].completed) {
             completed++;
         }
     }
@@ -169,10 +379,183 @@ int TaskTreeWidget::getTaskProgress(const QString& taskId) const
     return total > 0 ? (completed * 100) / total : 0;
 }
 
+bool TaskTreeWidget::moveTask(const TaskId& taskId, const TaskId& newParentId, int index)
+{
+    if (!taskMap.contains(taskId)) return false;
+    if (!newParentId.isNull() && !taskMap.contains(newParentId)) return false;
+
+    // A task cannot become a child of itself or of one of its own subtasks
+    if (taskId == newParentId || isDescendantOf(newParentId, taskId)) return false;
+
+    TaskId oldParentId = getStore()[taskId].parentId;
+
+    // Listeners get the index as requested; replaying it repeats the same adjustment below
+    const int requestedIndex = index;
+
+    // The subtree may change roots; take it out of the per-root counts first
+    TaskId oldRootId = getRootTaskId(taskId);
+    const QList<Task> movedTasks = getSubtree(taskId);
+    for (const Task& task : movedTasks) {
+        stats.removeTask(task, oldRootId);
+    }
+
+    // Unlink from the old sibling list
+    QList<TaskId>& oldSiblings = oldParentId.isNull() ? mainTaskIds : taskMap[oldParentId].subtaskIds;
+    int oldIndex = oldSiblings.indexOf(taskId);
+    if (oldIndex >= 0) {
+        oldSiblings.removeAt(oldIndex);
+        if (oldParentId == newParentId && index > oldIndex) {
+            index--;
+        }
+    }
+
+    // Link into the new sibling list
+    QList<TaskId>& newSiblings = newParentId.isNull() ? mainTaskIds : taskMap[newParentId].subtaskIds;
+    if (index < 0 || index > newSiblings.size()) {
+        index = newSiblings.size();
+    }
+    newSiblings.insert(index, taskId);
+
+    taskMap[taskId].parentId = newParentId;
+    updateSubtreeLevels(taskId);
+
+    TaskId newRootId = getRootTaskId(taskId);
+    for (const Task& task : movedTasks) {
+        stats.addTask(task, newRootId);
+    }
+
+    // Depths changed across the whole subtree
+    for (const Task& task : getSubtree(taskId)) {
+        columns.updateTask(task);
+    }
+
+    // Move the existing row when both ends are on screen, otherwise rebuild
+    QTreeWidgetItem* item = itemMap.value(taskId);
+    QTreeWidgetItem* newParentItem = itemMap.value(newParentId);
+    bool parentShown = newParentId.isNull() || newParentItem;
+    if (batchDepth == 0 && !showAncestors && item && parentShown
+        && matchesFilter(getStore()[taskId], currentFilter)) {
+        // Row position among the siblings that are actually displayed
+        int row = 0;
+        for (int i = 0; i < index; ++i) {
+            if (itemMap.contains(newSiblings[i])) {
+                row++;
+            }
+        }
+
+        blockSignals(true);
+        if (QTreeWidgetItem* oldParentItem = item->parent()) {
+            oldParentItem->removeChild(item);
+        } else {
+            takeTopLevelItem(indexOfTopLevelItem(item));
+        }
+        if (newParentItem) {
+            newParentItem->insertChild(row, item);
+        } else {
+            insertTopLevelItem(row, item);
+        }
+        expandSubtree(item);
+        blockSignals(false);
+        setCurrentItem(item);
+
+        refreshRollup(oldParentId);
+        refreshRollup(newParentId);
+    } else {
+        refreshRollup(oldParentId);
+        refreshRollup(newParentId);
+        applyCurrentFilter();
+    }
+
+    emit taskMoved(taskId, newParentId, requestedIndex);
+    emit statisticsChanged();
+    return true;
+}
+
+QList<Task> TaskTreeWidget::getSubtree(const TaskId& taskId) const
+{
+    QList<Task> subtree;
+    if (!taskMap.contains(taskId)) return subtree;
+
+    // Parents always precede their subtasks
+    QList<TaskId> pending = {taskId};
+    for (int i = 0; i < pending.size(); ++i) {
+        if (taskMap.contains(pending[i])) {
+            const Task task = getStore()[pending[i]];
+            subtree.append(task);
+            pending.append(task.subtaskIds);
+        }
+    }
+    return subtree;
+}
+
+QList<TaskId> TaskTreeWidget::getArchivableTaskIds(const QDateTime& completedBefore) const
+{
+    QList<TaskId> archivable;
+    for (const TaskId& mainTaskId : mainTaskIds) {
+        const QList<Task> subtree = getSubtree(mainTaskId);
+        bool finished = !subtree.isEmpty();
+        for (const Task& task : subtree) {
+            if (!task.completed || !task.completedDate.isValid() || task.completedDate > completedBefore) {
+                finished = false;
+                break;
+            }
+        }
+        if (finished) {
+            archivable.append(mainTaskId);
+        }
+    }
+    return archivable;
+}
+
+void TaskTreeWidget::dropEvent(QDropEvent* event)
+{
+    QTreeWidgetItem* draggedItem = currentItem();
+    if (!draggedItem || event->source() != this) {
+        event->ignore();
+        return;
+    }
+    TaskId taskId = draggedItem->data(0, Qt::UserRole).value<TaskId>();
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    QTreeWidgetItem* targetItem = itemAt(event->position().toPoint());
+#else
+    QTreeWidgetItem* targetItem = itemAt(event->pos());
+#endif
+
+    TaskId newParentId;
+    int index = -1;
+    if (targetItem) {
+        TaskId targetId = targetItem->data(0, Qt::UserRole).value<TaskId>();
+        switch (dropIndicatorPosition()) {
+        case QAbstractItemView::OnItem:
+            newParentId = targetId;
+            break;
+        case QAbstractItemView::AboveItem:
+        case QAbstractItemView::BelowItem: {
+            newParentId = getStore()[targetId].parentId;
+            const QList<TaskId>& siblings = newParentId.isNull() ? mainTaskIds : getStore()[newParentId].subtaskIds;
+            index = siblings.indexOf(targetId);
+            if (dropIndicatorPosition() == QAbstractItemView::BelowItem) {
+                index++;
+            }
+            break;
+        }
+        case QAbstractItemView::OnViewport:
+            break;
+        }
+    }
+
+    // The model is relinked by moveTask(); keep QTreeWidget from moving rows itself
+    event->setDropAction(Qt::IgnoreAction);
+    event->accept();
+
+    moveTask(taskId, newParentId, index);
+}
+
 void TaskTreeWidget::onItemChanged(QTreeWidgetItem* item, int column)
 {
     if (column == 3) { // Status column
-        QString taskId = item->data(0, Qt::UserRole).toString();
+        TaskId taskId = item->data(0, Qt::UserRole).value<TaskId>();
 
         if (taskMap.contains(taskId)) {
 
@@ -184,13 +567,21 @@ void TaskTreeWidget::onItemChanged(QTreeWidgetItem* item, int column)
             {
                 bool completed = item->checkState(3) == Qt::Checked;
 
-                taskMap[taskId].completed = completed;
+                Task before = getStore()[taskId];
+                taskMap[taskId].setCompleted(completed);
+                stats.updateTask(before, getStore()[taskId], getRootTaskId(taskId));
+                tagIndex.updateTask(before, getStore()[taskId]);
+                dependencies.updateTask(getStore()[taskId]);
+                columns.updateTask(getStore()[taskId]);
                 blockSignals(true);
-                updateTaskAppearance(item, taskMap[taskId]);
+                updateTaskAppearance(item, getStore()[taskId]);
                 blockSignals(false);
 
+                emit taskChanged(taskId);
+
                 // Update parent completion status
                 updateParentCompletion(taskId);
+                emit statisticsChanged();
 
                 // Emit signal safely using QTimer to defer it
                 QTimer::singleShot(0, [this, taskId]() {
@@ -209,32 +600,214 @@ void TaskTreeWidget::onItemChanged(QTreeWidgetItem* item, int column)
 
 bool TaskTreeWidget::matchesFilter(const Task& task, const QString& filter)
 {
-    if (filter == "All Tasks") {
-        return true;
-    } else if (filter == "Pending") {
-        return !task.completed;
-    } else if (filter == "Completed") {
-        return task.completed;
-    } else if (filter == "High Priority") {
-        return task.priority == "High";
-    } else if (filter == "Due Today") {
-        QDate today = QDate::currentDate();
-        return task.dueDate.date() == today;
-    } else if (filter == "Main Tasks Only") {
-        return task.isMainTask();
+    // A finished parallel pass already folded in the tag query
+    if (hasPassResult && filter == currentFilter) {
+        return matchedTasks.contains(task.id);
+    }
+
+    if (!appliedQuery.isEmpty() && !tagIndex.contains(queryResult, task.id)) {
+        return false;
+    }
+
+    if (hasFilterSelection && filter == currentFilter) {
+        return ParallelScan::matchesSelection(task, filter, columns, filterSelection);
     }
+
+    return ParallelScan::matchesFilter(task, filter, dependencies);
+}
+
+bool TaskTreeWidget::isShown(const Task& task)
+{
+    return showAncestors ? visibleTasks.contains(task.id) : matchesFilter(task, currentFilter);
+}
+
+void TaskTreeWidget::computeVisibleTasks()
+{
+    matchedTasks.clear();
+    visibleTasks.clear();
+
+    // Breadth-first order puts every parent before its subtasks
+    QList<TaskId> order;
+    order.reserve(taskMap.size());
+    order.append(mainTaskIds);
+    for (int i = 0; i < order.size(); ++i) {
+        order.append(getStore()[order[i]].subtaskIds);
+    }
+
+    // One reverse sweep: a task is visible if it matches or any subtask is visible
+    for (int i = order.size() - 1; i >= 0; --i) {
+        const Task& task = getStore()[order[i]];
+        bool matched = matchesFilter(task, currentFilter);
+        if (matched) {
+            matchedTasks.insert(task.id);
+        }
+        if (matched || visibleTasks.contains(task.id)) {
+            visibleTasks.insert(task.id);
+            if (!task.parentId.isNull()) {
+                visibleTasks.insert(task.parentId);
+            }
+        }
+    }
+}
+
+bool TaskTreeWidget::addDependency(const TaskId& taskId, const TaskId& blockerId)
+{
+    if (!taskMap.contains(taskId) || !taskMap.contains(blockerId)) return false;
+
+    // Rejected if the blocker already (transitively) waits on this task
+    if (!dependencies.addDependency(blockerId, taskId)) return false;
+
+    if (!getStore()[taskId].blockedBy.contains(blockerId)) {
+        taskMap[taskId].blockedBy.append(blockerId);
+    }
+    applyCurrentFilter();
+    emit taskChanged(taskId);
     return true;
 }
 
+void TaskTreeWidget::removeDependency(const TaskId& taskId, const TaskId& blockerId)
+{
+    if (!taskMap.contains(taskId)) return;
+
+    dependencies.removeDependency(blockerId, taskId);
+    taskMap[taskId].blockedBy.removeAll(blockerId);
+    applyCurrentFilter();
+    emit taskChanged(taskId);
+}
+
+const DependencyGraph& TaskTreeWidget::getDependencies() const
+{
+    return dependencies;
+}
+
+void TaskTreeWidget::applyQuery(const QString& query)
+{
+    currentQuery = query.trimmed();
+    applyCurrentFilter();
+}
+
+QString TaskTreeWidget::getQueryError() const
+{
+    return queryError;
+}
+
+const TagIndex& TaskTreeWidget::getTagIndex() const
+{
+    return tagIndex;
+}
+
+void TaskTreeWidget::setShowAncestors(bool show)
+{
+    showAncestors = show;
+    applyCurrentFilter();
+}
+
+void TaskTreeWidget::beginBatch()
+{
+    batchDepth++;
+}
+
+void TaskTreeWidget::endBatch()
+{
+    if (--batchDepth > 0 || !filterDeferred) return;
+    filterDeferred = false;
+    applyCurrentFilter();
+}
+
 void TaskTreeWidget::applyCurrentFilter()
+{
+    if (batchDepth > 0) {
+        filterDeferred = true;
+        return;
+    }
+
+    // The tag query is one word-wise bitmap expression, evaluated here so its error
+    // shows at once. A query that does not parse, usually one still being typed,
+    // leaves the last one that did in effect.
+    queryError.clear();
+    if (currentQuery.isEmpty()) {
+        appliedQuery.clear();
+    } else {
+        TaskBitmap result = tagIndex.evaluate(currentQuery, &queryError);
+        if (queryError.isEmpty()) {
+            queryResult = result;
+            appliedQuery = currentQuery;
+        } else if (!appliedQuery.isEmpty()) {
+            queryResult = tagIndex.evaluate(appliedQuery);
+        }
+    }
+
+    // Whatever pass is still running was asked for an older filter or store. Large
+    // boards are filtered on the pool, straight from a store snapshot.
+    filterWatcher.cancel();
+    if (taskMap.size() >= ParallelScanThreshold) {
+        startFilterPass();
+        return;
+    }
+
+    // Column filters run over every task at once; matchesFilter() then only tests a bit
+    hasFilterSelection = true;
+    if (currentFilter == "Pending") {
+        filterSelection = columns.pending();
+    } else if (currentFilter == "Completed") {
+        filterSelection = columns.completed();
+    } else if (currentFilter == "High Priority") {
+        filterSelection = columns.priorityEquals("High");
+    } else if (currentFilter == "Due Today") {
+        QDateTime startOfToday(QDate::currentDate(), QTime(0, 0));
+        filterSelection = columns.dueBetween(startOfToday, startOfToday.addDays(1));
+    } else {
+        hasFilterSelection = false;
+    }
+
+    if (showAncestors) {
+        computeVisibleTasks();
+    }
+
+    rebuildItems();
+    hasFilterSelection = false;
+}
+
+void TaskTreeWidget::startFilterPass()
+{
+    // The rows on screen stay until the pass finishes
+    ParallelScan::Filter filter;
+    filter.kind = ParallelScan::filterKind(currentFilter);
+    filter.today = QDate::currentDate();
+    filter.hasQuery = !appliedQuery.isEmpty();
+    if (filter.hasQuery) {
+        filter.query = tagIndex.result(queryResult);
+    }
+    if (filter.kind == ParallelScan::Ready || filter.kind == ParallelScan::Blocked) {
+        filter.dependencies = std::make_shared<const DependencyGraph>(dependencies);
+    }
+    filter.showAncestors = showAncestors;
+    filterWatcher.setFuture(ParallelScan::filter(taskMap.snapshot(), filter));
+}
+
+void TaskTreeWidget::onFilterPassFinished()
+{
+    if (filterWatcher.isCanceled()) return;
+
+    ParallelScan::Matches matches = filterWatcher.result();
+    matchedTasks = std::move(matches.matched);
+    visibleTasks = std::move(matches.visible);
+
+    hasPassResult = true;
+    rebuildItems();
+    hasPassResult = false;
+}
+
+void TaskTreeWidget::rebuildItems()
 {
     clear();
+    itemMap.clear();
     disconnect(this, &QTreeWidget::itemChanged, this, &TaskTreeWidget::onItemChanged);
 
-    for (const QString& mainTaskId : mainTaskIds) {
+    for (const TaskId& mainTaskId : mainTaskIds) {
         if (taskMap.contains(mainTaskId)) {
-            const Task& mainTask = taskMap[mainTaskId];
-            if (matchesFilter(mainTask, currentFilter)) {
+            const Task& mainTask = getStore()[mainTaskId];
+            if (isShown(mainTask)) {
                 QTreeWidgetItem* mainItem = createTaskItem(mainTask);
                 addTopLevelItem(mainItem);
                 addSubtaskItems(mainItem, mainTaskId);
@@ -250,15 +823,15 @@ void TaskTreeWidget::applyCurrentFilter()
     connect(this, &QTreeWidget::itemChanged, this, &TaskTreeWidget::onItemChanged);
 }
 
-void TaskTreeWidget::addSubtaskItems(QTreeWidgetItem* parentItem, const QString& parentTaskId)
+void TaskTreeWidget::addSubtaskItems(QTreeWidgetItem* parentItem, const TaskId& parentTaskId)
 {
     if (!taskMap.contains(parentTaskId)) return;
 
-    const Task& parentTask = taskMap[parentTaskId];
-    for (const QString& subtaskId : parentTask.subtaskIds) {
+    const Task& parentTask = getStore()[parentTaskId];
+    for (const TaskId& subtaskId : parentTask.subtaskIds) {
         if (taskMap.contains(subtaskId)) {
-            const Task& subtask = taskMap[subtaskId];
-            if (matchesFilter(subtask, currentFilter)) {
+            const Task& subtask = getStore()[subtaskId];
+            if (isShown(subtask)) {
                 QTreeWidgetItem* subtaskItem = createTaskItem(subtask);
                 parentItem->addChild(subtaskItem);
 
@@ -275,8 +848,9 @@ void TaskTreeWidget::addSubtaskItems(QTreeWidgetItem* parentItem, const QString&
 QTreeWidgetItem* TaskTreeWidget::createTaskItem(const Task& task)
 {
     QTreeWidgetItem* item = new QTreeWidgetItem();
-    item->setData(0, Qt::UserRole, task.id);
+    item->setData(0, Qt::UserRole, QVariant::fromValue(task.id));
     updateTaskAppearance(item, task);
+    itemMap[task.id] = item;
     return item;
 }
 
@@ -284,6 +858,9 @@ void TaskTreeWidget::updateTaskAppearance(QTreeWidgetItem* item, const Task& tas
 {
     // Task name with progress indicator
     QString taskText = task.title;
+    if (task.recurrence.isRecurring()) {
+        taskText += QString(" ") + QChar(0x21BB); // Clockwise arrow: repeats
+    }
     if (task.hasSubtasks()) {
         int progress = getTaskProgress(task.id);
         taskText += QString(" (%1%)").arg(progress);
@@ -314,6 +891,13 @@ void TaskTreeWidget::updateTaskAppearance(QTreeWidgetItem* item, const Task& tas
             item->setForeground(0, QColor(0, 128, 0));
         }
     }
+
+    // Ancestors shown only for context are greyed out
+    bool contextOnly = showAncestors && !matchedTasks.contains(task.id);
+    font.setItalic(contextOnly);
+    if (contextOnly) {
+        item->setForeground(0, QColor(170, 170, 170));
+    }
     item->setFont(0, font);
 
     // Add icon for tasks with subtasks
@@ -324,23 +908,27 @@ void TaskTreeWidget::updateTaskAppearance(QTreeWidgetItem* item, const Task& tas
     }
 }
 
-void TaskTreeWidget::updateParentCompletionSafe(const QString& taskId) {
-    if (taskId.isEmpty() || !taskMap.contains(taskId)) return;
+void TaskTreeWidget::updateParentCompletionSafe(const TaskId& taskId) {
+    if (taskId.isNull() || !taskMap.contains(taskId)) return;
+
+    const Task& task = getStore()[taskId];
+    if (task.parentId.isNull() || !taskMap.contains(task.parentId)) return;
 
-    const Task& task = taskMap[taskId];
-    if (task.parentId.isEmpty() || !taskMap.contains(task.parentId)) return;
+    TaskId parentId = task.parentId;
+    const Task& parent = getStore()[parentId];
 
-    QString parentId = task.parentId;
-    const Task& parent = taskMap[parentId];
+    // Completing a recurring task only closes an occurrence; its subtasks stay
+    // done, so rolling up would close another one on every later change
+    if (parent.recurrence.isRecurring()) return;
 
     // Check completion of all subtasks
     int completedCount = 0;
     int totalCount = 0;
 
-    for (const QString& subtaskId : parent.subtaskIds) {
+    for (const TaskId& subtaskId : parent.subtaskIds) {
         if (taskMap.contains(subtaskId)) {
             totalCount++;
-            if (taskMap[subtaskId].completed) {
+            if (getStore()[subtaskId].completed) {
                 completedCount++;
             }
         }
@@ -350,19 +938,20 @@ void TaskTreeWidget::updateParentCompletionSafe(const QString& taskId) {
     bool shouldBeCompleted = (totalCount > 0 && completedCount == totalCount);
 
     // Only update if status actually changed
-    if (taskMap[parentId].completed != shouldBeCompleted) {
-        taskMap[parentId].completed = shouldBeCompleted;
+    if (getStore()[parentId].completed != shouldBeCompleted) {
+        Task before = getStore()[parentId];
+        taskMap[parentId].setCompleted(shouldBeCompleted);
+        stats.updateTask(before, getStore()[parentId], getRootTaskId(parentId));
+        tagIndex.updateTask(before, getStore()[parentId]);
+        dependencies.updateTask(getStore()[parentId]);
+        columns.updateTask(getStore()[parentId]);
+        emit taskChanged(parentId);
 
-        // Find and update the parent item display
-        QTreeWidgetItemIterator it(this);
-        while (*it) {
-            if ((*it)->data(0, Qt::UserRole).toString() == parentId) {
-                blockSignals(true);
-                updateTaskAppearance(*it, taskMap[parentId]);
-                blockSignals(false);
-                break;
-            }
-            ++it;
+        // Update the parent item display
+        if (QTreeWidgetItem* parentItem = itemMap.value(parentId)) {
+            blockSignals(true);
+            updateTaskAppearance(parentItem, getStore()[parentId]);
+            blockSignals(false);
         }
 
         // Continue up the hierarchy recursively but safely
@@ -370,7 +959,7 @@ void TaskTreeWidget::updateParentCompletionSafe(const QString& taskId) {
     }
 }
 
-void TaskTreeWidget::updateParentCompletion(const QString& taskId)
+void TaskTreeWidget::updateParentCompletion(const TaskId& taskId)
 {
     // if (!taskMap.contains(taskId)) return;
 
@@ -395,3 +984,147 @@ void TaskTreeWidget::updateParentCompletion(const QString& taskId)
     // }
     updateParentCompletionSafe(taskId);
 }
+
+TaskId TaskTreeWidget::getRootTaskId(const TaskId& taskId) const
+{
+    TaskId currentId = taskId;
+    const Task* task = taskMap.find(currentId);
+    while (task && !task->parentId.isNull() && taskMap.contains(task->parentId)) {
+        currentId = task->parentId;
+        task = taskMap.find(currentId);
+    }
+    return currentId;
+}
+
+int TaskTreeWidget::getTaskIndex(const TaskId& taskId) const
+{
+    // Position among its siblings, -1 if the task is not in the tree
+    const Task* task = taskMap.find(taskId);
+    if (!task) return -1;
+    if (task->parentId.isNull() || !taskMap.contains(task->parentId)) {
+        return mainTaskIds.indexOf(taskId);
+    }
+    return taskMap.find(task->parentId)->subtaskIds.indexOf(taskId);
+}
+
+const TaskStats& TaskTreeWidget::getStatistics()
+{
+    // Due buckets are relative to the day they were counted on
+    if (stats.referenceDate() != QDate::currentDate()) {
+        rebuildStats();
+    }
+    return stats;
+}
+
+void TaskTreeWidget::rebuildStats()
+{
+    if (taskMap.size() >= ParallelScanThreshold) {
+        stats = ParallelScan::statistics(taskMap.snapshot());
+        return;
+    }
+
+    stats.clear();
+    taskMap.forEach([this](const Task& task) {
+        stats.addTask(task, getRootTaskId(task.id));
+    });
+}
+
+bool TaskTreeWidget::isDescendantOf(const TaskId& taskId, const TaskId& ancestorId) const
+{
+    TaskId currentId = taskId;
+    while (!currentId.isNull() && taskMap.contains(currentId)) {
+        currentId = getStore()[currentId].parentId;
+        if (currentId == ancestorId) return true;
+    }
+    return false;
+}
+
+void TaskTreeWidget::updateSubtreeLevels(const TaskId& taskId)
+{
+    if (!taskMap.contains(taskId)) return;
+
+    const TaskId parentId = getStore()[taskId].parentId;
+    const int level = taskMap.contains(parentId) ? getStore()[parentId].level + 1 : 0;
+    if (getStore()[taskId].level != level) {
+        taskMap[taskId].level = level;
+    }
+
+    // Only the moved subtree changes depth; tasks already at the right depth stay shared
+    QList<TaskId> pending = getStore()[taskId].subtaskIds;
+    for (int i = 0; i < pending.size(); ++i) {
+        const Task* task = getStore().find(pending[i]);
+        if (!task) continue;
+
+        const int subtaskLevel = getStore()[task->parentId].level + 1;
+        pending.append(task->subtaskIds);
+        if (task->level != subtaskLevel) {
+            taskMap[pending[i]].level = subtaskLevel;
+        }
+    }
+}
+
+void TaskTreeWidget::refreshRollup(const TaskId& taskId)
+{
+    // Recompute completion and progress for taskId, then walk up while it keeps changing
+    TaskId currentId = taskId;
+    while (!currentId.isNull() && taskMap.contains(currentId)) {
+        // Read a copy and write it back only if the rollup changes
+        Task task = getStore()[currentId];
+
+        // Recurring tasks are left alone, as in updateParentCompletionSafe()
+        bool changed = false;
+        if (task.hasSubtasks() && !task.recurrence.isRecurring()) {
+            bool allCompleted = true;
+            for (const TaskId& subtaskId : task.subtaskIds) {
+                if (taskMap.contains(subtaskId) && !getStore()[subtaskId].completed) {
+                    allCompleted = false;
+                    break;
+                }
+            }
+            changed = task.completed != allCompleted;
+            if (changed) {
+                Task before = task;
+                task.setCompleted(allCompleted);
+                taskMap.insert(task);
+                stats.updateTask(before, task, getRootTaskId(currentId));
+                tagIndex.updateTask(before, task);
+                dependencies.updateTask(task);
+                columns.updateTask(task);
+                emit taskChanged(currentId);
+            }
+        }
+
+        if (QTreeWidgetItem* item = itemMap.value(currentId)) {
+            blockSignals(true);
+            updateTaskAppearance(item, task);
+            blockSignals(false);
+        }
+
+        if (!changed) break;
+        currentId = task.parentId;
+    }
+}
+
+void TaskTreeWidget::dropRejectedBlockers(const QHash<TaskId, QList<TaskId>>& rejected)
+{
+    // A blocker the graph refused (unknown id or a cycle) would otherwise stay in
+    // the task and be saved again, though nothing shows or enforces it
+    for (auto it = rejected.constBegin(); it != rejected.constEnd(); ++it) {
+        if (!taskMap.contains(it.key())) continue;
+        QList<TaskId>& blockedBy = taskMap[it.key()].blockedBy;
+        for (const TaskId& blockerId : it.value()) {
+            blockedBy.removeAll(blockerId);
+        }
+    }
+}
+
+void TaskTreeWidget::expandSubtree(QTreeWidgetItem* item)
+{
+    // Taking a row out of the view drops its expansion state
+    if (item->childCount() > 0) {
+        item->setExpanded(true);
+    }
+    for (int i = 0; i < item->childCount(); ++i) {
+        expandSubtree(item->child(i));
+    }
+}
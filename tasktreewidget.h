@@ -3,7 +3,16 @@
 
 #include <QTreeWidget>
 #include <QTreeWidgetItem>
+#include <QHash>
+#include <QSet>
+#include <QFutureWatcher>
 #include "task.h"
+#include "taskstats.h"
+#include "taskstore.h"
+#include "tagindex.h"
+#include "dependencygraph.h"
+#include "taskcolumns.h"
+#include "parallelscan.h"
 
 class TaskTreeWidget : public QTreeWidget
 {
@@ -11,38 +20,105 @@ class TaskTreeWidget : public QTreeWidget
 
 public:
     TaskTreeWidget();
+    ~TaskTreeWidget() override;
     void addTask(const Task& task);
-    void removeTask(const QString& taskId);
-    void updateTask(const QString& taskId, const Task& newTask);
+    void addTasks(const QList<Task>& tasks);
+    void removeTask(const TaskId& taskId);
+    void removeTasks(const QList<TaskId>& taskIds);
+    void updateTask(const TaskId& taskId, const Task& newTask);
     Task getTask(QTreeWidgetItem* item) const;
+    Task getTaskById(const TaskId& taskId) const;
     Task getSelectedTask() const;
-    QString getSelectedTaskId() const;
-    void addSubtask(const QString& parentId, const Task& subtask);
+    TaskId getSelectedTaskId() const;
+    bool selectTask(const TaskId& taskId);
+    void setTaskCompleted(const TaskId& taskId, bool completed);
+    void addSubtask(const TaskId& parentId, const Task& subtask);
     bool canAddSubtask() const;
-    QList<Task> getAllTasks() const;
+    QList<Task> getAllTasks() const; // Main tasks first, in board order
+    QList<TaskId> getMainTaskIds() const;
+    const TaskStore& getStore() const;
+    TaskStore getSnapshot() const;
     void setAllTasks(const QList<Task>& tasks);
     void applyFilter(const QString& filterType);
-    int getTaskProgress(const QString& taskId) const;
+    void setShowAncestors(bool show);
+    void applyQuery(const QString& query);
+    QString getQueryError() const;
+    const TagIndex& getTagIndex() const;
+    bool addDependency(const TaskId& taskId, const TaskId& blockerId);
+    void removeDependency(const TaskId& taskId, const TaskId& blockerId);
+    const DependencyGraph& getDependencies() const;
+    int getTaskProgress(const TaskId& taskId) const;
+    bool moveTask(const TaskId& taskId, const TaskId& newParentId, int index = -1);
+    QList<Task> getSubtree(const TaskId& taskId) const;
+    QList<TaskId> getArchivableTaskIds(const QDateTime& completedBefore) const;
+    TaskId getRootTaskId(const TaskId& taskId) const;
+    int getTaskIndex(const TaskId& taskId) const;
+    const TaskStats& getStatistics();
+
+    // Between these, mutations only mark the view stale; the outermost
+    // endBatch() refilters and rebuilds it once. Calls may nest.
+    void beginBatch();
+    void endBatch();
 
 public slots:
     void onItemChanged(QTreeWidgetItem* item, int column);
 
 signals:
-    void taskToggled(const QString& taskId);
+    void taskToggled(const TaskId& taskId);
+    void taskMoved(const TaskId& taskId, const TaskId& newParentId, int index);
+    void statisticsChanged();
+
+    // Fine-grained changes for views that read the store directly
+    void tasksAdded(const QList<TaskId>& taskIds);
+    void tasksRemoved(const QList<TaskId>& taskIds);
+    void taskChanged(const TaskId& taskId);
+    void tasksReset();
+
+protected:
+    void dropEvent(QDropEvent* event) override;
 
 private:
-    QMap<QString, Task> taskMap;
-    QList<QString> mainTaskIds;
+    TaskStore taskMap;
+    QList<TaskId> mainTaskIds;
+    QHash<TaskId, QTreeWidgetItem*> itemMap; // Rows currently shown, by task id
     QString currentFilter = "All Tasks";
+    TaskStats stats;
+    TagIndex tagIndex;
+    DependencyGraph dependencies;
+    TaskColumns columns;
+    TaskColumns::Selection filterSelection;
+    bool hasFilterSelection = false; // Only during a pass on the GUI thread
+    QFutureWatcher<ParallelScan::Matches> filterWatcher;
+    bool hasPassResult = false; // matchedTasks/visibleTasks came from a finished parallel pass
+    QString currentQuery;
+    QString appliedQuery; // The last query that parsed; the view filters by this one
+    TaskBitmap queryResult;
+    QString queryError;
+    bool showAncestors = false; // Keep the parent path of matching subtasks
+    QSet<TaskId> matchedTasks;
+    QSet<TaskId> visibleTasks;
+    int batchDepth = 0;
+    bool filterDeferred = false;
     static bool isUpdating;
 
     bool matchesFilter(const Task& task, const QString& filter);
     void applyCurrentFilter();
-    void addSubtaskItems(QTreeWidgetItem* parentItem, const QString& parentTaskId);
+    void startFilterPass();
+    void onFilterPassFinished();
+    void rebuildItems();
+    void computeVisibleTasks();
+    bool isShown(const Task& task);
+    void addSubtaskItems(QTreeWidgetItem* parentItem, const TaskId& parentTaskId);
     QTreeWidgetItem* createTaskItem(const Task& task);
     void updateTaskAppearance(QTreeWidgetItem* item, const Task& task);
-    void updateParentCompletion(const QString& taskId);
-    void updateParentCompletionSafe(const QString& taskId);
+    void updateParentCompletion(const TaskId& taskId);
+    void updateParentCompletionSafe(const TaskId& taskId);
+    bool isDescendantOf(const TaskId& taskId, const TaskId& ancestorId) const;
+    void updateSubtreeLevels(const TaskId& taskId);
+    void refreshRollup(const TaskId& taskId);
+    void dropRejectedBlockers(const QHash<TaskId, QList<TaskId>>& rejected);
+    void expandSubtree(QTreeWidgetItem* item);
+    void rebuildStats();
 
 };
 
@@ -0,0 +1,667 @@
+#include "descriptionstore.h"
+#include "stringpool.h"
+#include "syncmessage.h"
+#include "tagindex.h"
+#include "taskfile.h"
+#include "taskstats.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QLocalSocket>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+// Works on the same files as the TaskManager window, without QtWidgets. Every
+// command streams the task file through TaskFileReader/TaskFileWriter and the
+// input through a line reader, so only ids are held: import keeps the ids on the
+// board and the ones it has written (16 bytes each, in a sorted array), to skip
+// rows that are already there.
+//
+// Usage: taskctl [--data-dir dir] [--format csv|ndjson] <command>
+//   import FILE          append tasks from FILE ("-" for stdin)
+//   export [FILE]        write every task to FILE (default stdout)
+//   query EXPR [FILE]    write the tasks matching a tag query, e.g. "tag:backend AND pending"
+//   stats [EXPR]         print counts, for every task or the ones matching EXPR
+//   compact              rewrite the description blob without text no task uses
+//
+// Records carry id, parent, title, description, due, priority, completed, tags
+// and created, as CSV columns (with a header row) or NDJSON keys; NDJSON also
+// takes the task file's own key names. An id or parent that is not a UUID is
+// mapped to the same TaskId every time, so rows can refer to parents by any key.
+// Run it while TaskManager is closed: the window rewrites the file on exit, so
+// import and compact refuse to run while one answers on the board's sync socket.
+
+namespace {
+
+enum class Format { Csv, Ndjson };
+
+const char* const TaskFileName = "tasks_with_subtasks.json";
+const char* const DescriptionFileName = "task_descriptions.blob";
+const char* const JournalFileNames[] = {"tasks_journal.ndjson", "tasks_journal.pending"};
+const char* const CsvColumns[] = {"id", "parent", "title", "description", "due", "priority", "completed", "tags",
+                                  "created"};
+
+// Tags are matched per chunk, so the bitmaps never span more than this many tasks
+const int QueryChunkSize = 64 * 1024;
+
+// Parent depths kept for the level of the rows that follow; forgotten in bulk when full
+const int LevelCacheSize = 1 << 20;
+
+// Ids imported this run wait in a small set before being merged into the sorted ids
+const int IdMergeBatch = 64 * 1024;
+
+const int MaxReportedErrors = 10;
+
+QTextStream& err()
+{
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+// Rows per second on stderr: a running figure while the work goes on, then a summary
+class Throughput
+{
+public:
+    explicit Throughput(const QString& verb) : verb(verb) { timer.start(); }
+
+    void row()
+    {
+        if ((++rows & 0xFFFF) == 0 && timer.elapsed() - lastReportMs >= 1000) {
+            report();
+            err() << '\r' << Qt::flush;
+        }
+    }
+
+    void finish()
+    {
+        report();
+        err() << " in " << QString::number(timer.elapsed() / 1000.0, 'f', 2) << " s\n" << Qt::flush;
+    }
+
+private:
+    QString verb;
+    QElapsedTimer timer;
+    qint64 rows = 0;
+    qint64 lastReportMs = 0;
+
+    void report()
+    {
+        lastReportMs = timer.elapsed();
+        qint64 perSecond = rows * 1000 / qMax<qint64>(lastReportMs, 1);
+        err() << verb << ' ' << rows << " rows, " << perSecond << " rows/s";
+    }
+};
+
+QString dataPath(const QString& dataDir, const QString& fileName)
+{
+    return dataDir + "/" + fileName;
+}
+
+bool hasJournal(const QString& dataDir)
+{
+    for (const char* fileName : JournalFileNames) {
+        if (QFile::exists(dataPath(dataDir, fileName))) return true;
+    }
+    return false;
+}
+
+bool openInput(QFile& file, const QString& name)
+{
+    if (name == "-") return file.open(stdin, QIODevice::ReadOnly);
+    file.setFileName(name);
+    return file.open(QIODevice::ReadOnly);
+}
+
+bool openOutput(QFile& file, const QString& name)
+{
+    if (name.isEmpty() || name == "-") return file.open(stdout, QIODevice::WriteOnly);
+    file.setFileName(name);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+}
+
+// One record; a quoted field may run over several lines
+bool readCsvRecord(QIODevice& in, QStringList& fields, qint64& lineNumber)
+{
+    fields.clear();
+    QByteArray line = in.readLine();
+    if (line.isEmpty()) return false;
+
+    QString field;
+    bool quoted = false;
+    for (;;) {
+        lineNumber++;
+        const QString text = QString::fromUtf8(line);
+        for (int i = 0; i < text.size(); ++i) {
+            QChar c = text[i];
+            if (quoted) {
+                if (c != '"') {
+                    field += c;
+                } else if (i + 1 < text.size() && text[i + 1] == '"') {
+                    field += c;
+                    ++i;
+                } else {
+                    quoted = false;
+                }
+            } else if (c == '"') {
+                quoted = true;
+            } else if (c == ',') {
+                fields.append(field);
+                field.clear();
+            } else if (c != '\n' && c != '\r') {
+                field += c;
+            }
+        }
+        if (!quoted) break;
+        line = in.readLine();
+        if (line.isEmpty()) break;
+    }
+    fields.append(field);
+    return true;
+}
+
+QString csvField(const QString& text)
+{
+    if (!text.contains('"') && !text.contains(',') && !text.contains('\n') && !text.contains('\r')) return text;
+    return "\"" + QString(text).replace("\"", "\"\"") + "\"";
+}
+
+QJsonObject recordFromCsv(const QStringList& fields, const QHash<QString, int>& columns)
+{
+    auto value = [&](const char* column) {
+        int index = columns.value(column, -1);
+        return index >= 0 && index < fields.size() ? fields[index] : QString();
+    };
+
+    QString completed = value("completed").trimmed().toLower();
+    QJsonObject record;
+    record["id"] = value("id").trimmed();
+    record["parentId"] = value("parent").trimmed();
+    record["title"] = value("title").trimmed();
+    record["description"] = value("description");
+    record["dueDate"] = value("due").trimmed();
+    record["priority"] = value("priority").trimmed();
+    record["completed"] = completed == "1" || completed == "true" || completed == "yes" || completed == "x";
+    record["tags"] = QJsonArray::fromStringList(Task::parseTags(value("tags")));
+    record["createdDate"] = value("created").trimmed();
+    return record;
+}
+
+// The task an input record describes, before it is given a level and a description offset
+Task taskFromRecord(QJsonObject record)
+{
+    // Short keys and numeric ids are accepted alongside the task file's own form
+    if (!record.contains("parentId")) record["parentId"] = record.value("parent");
+    if (!record.contains("dueDate")) record["dueDate"] = record.value("due");
+    if (!record.contains("createdDate")) record["createdDate"] = record.value("created");
+    record["id"] = record.value("id").toVariant().toString();
+    record["parentId"] = record.value("parentId").toVariant().toString();
+    if (record.value("tags").isString()) {
+        record["tags"] = QJsonArray::fromStringList(Task::parseTags(record.value("tags").toString()));
+    }
+
+    Task task = Task::fromJson(record);
+    if (task.id.isNull()) {
+        task.id = TaskId::create();
+    }
+    if (task.priority.isEmpty()) {
+        task.priority = StringPool::shared().intern("Medium");
+    }
+    if (!task.createdDate.isValid()) {
+        task.createdDate = QDateTime::currentDateTime();
+    }
+    task.descriptionOffset = -1; // Offsets only mean something in this board's own blob
+    task.descriptionSize = 0;
+    task.subtaskIds.clear();     // Rebuilt from parentId on load
+    return task;
+}
+
+// Reads the next input record as a task; false at the end of the input
+class RecordReader
+{
+public:
+    RecordReader(QIODevice& in, Format format) : in(in), format(format) {}
+
+    bool readHeader(QString* error)
+    {
+        if (format != Format::Csv) return true;
+        QStringList header;
+        if (!readCsvRecord(in, header, lineNumber)) return true;
+        for (int i = 0; i < header.size(); ++i) {
+            columns.insert(header[i].trimmed().toLower(), i);
+        }
+        if (!columns.contains("title")) {
+            *error = "The CSV header has no title column";
+            return false;
+        }
+        return true;
+    }
+
+    bool next(Task& task, QString* error)
+    {
+        error->clear();
+        if (format == Format::Csv) {
+            QStringList fields;
+            do {
+                if (!readCsvRecord(in, fields, lineNumber)) return false;
+            } while (fields.size() == 1 && fields[0].trimmed().isEmpty());
+            task = taskFromRecord(recordFromCsv(fields, columns));
+            return true;
+        }
+
+        QByteArray line;
+        do {
+            line = in.readLine();
+            if (line.isEmpty()) return false;
+            lineNumber++;
+        } while (line.trimmed().isEmpty());
+
+        QJsonParseError parseError;
+        QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+        if (!document.isObject()) {
+            *error = QString("line %1: %2").arg(lineNumber).arg(parseError.errorString());
+            return true;
+        }
+        task = taskFromRecord(document.object());
+        return true;
+    }
+
+private:
+    QIODevice& in;
+    Format format;
+    QHash<QString, int> columns;
+    qint64 lineNumber = 0;
+};
+
+class RecordWriter
+{
+public:
+    RecordWriter(QIODevice& out, Format format, const DescriptionStore& descriptions)
+        : out(out), format(format), descriptions(descriptions)
+    {
+        if (format == Format::Csv) {
+            QStringList header;
+            for (const char* column : CsvColumns) {
+                header.append(column);
+            }
+            out.write(header.join(',').toUtf8() + "\n");
+        }
+    }
+
+    void write(Task task)
+    {
+        task.description = descriptions.text(task);
+        task.descriptionOffset = -1;
+        task.descriptionSize = 0;
+
+        if (format == Format::Ndjson) {
+            // Parent references only; subtask lists and levels follow from them
+            QJsonObject record = task.toJson();
+            record.remove("subtaskIds");
+            record.remove("level");
+            out.write(QJsonDocument(record).toJson(QJsonDocument::Compact));
+            out.write("\n");
+            return;
+        }
+
+        QStringList fields = {
+            task.id.toString(),
+            task.parentId.toString(),
+            csvField(task.title),
+            csvField(task.description),
+            task.dueDate.toString(Qt::ISODate),
+            csvField(task.priority),
+            task.completed ? "1" : "0",
+            csvField(task.tags.join(',')),
+            task.createdDate.toString(Qt::ISODate)
+        };
+        out.write(fields.join(',').toUtf8() + "\n");
+    }
+
+private:
+    QIODevice& out;
+    Format format;
+    const DescriptionStore& descriptions;
+};
+
+// Feeds each task on the board to the callback, or only the ones matching the
+// query; false with the reason if the file or the query is bad
+bool forEachTask(TaskFileReader& reader, const QString& query, const std::function<void(const Task&)>& callback,
+                 QString* error)
+{
+    Task task;
+    if (query.isEmpty()) {
+        while (reader.next(task)) {
+            callback(task);
+        }
+    } else {
+        TagIndex index;
+        index.evaluate(query, error);
+        if (!error->isEmpty()) return false;
+
+        QList<Task> chunk;
+        chunk.reserve(QueryChunkSize);
+        bool more = true;
+        while (more) {
+            more = reader.next(task);
+            if (more) {
+                chunk.append(task);
+                index.addTask(task);
+            }
+            if (chunk.size() == QueryChunkSize || (!more && !chunk.isEmpty())) {
+                TaskBitmap matches = index.evaluate(query);
+                for (const Task& candidate : chunk) {
+                    if (index.contains(matches, candidate.id)) {
+                        callback(candidate);
+                    }
+                }
+                chunk.clear();
+                index.clear();
+            }
+        }
+    }
+
+    if (reader.hasError()) {
+        *error = reader.errorString();
+        return false;
+    }
+    return true;
+}
+
+class TaskCtl
+{
+public:
+    TaskCtl(const QString& dataDir, const QString& formatName)
+        : dataDir(dataDir), formatName(formatName.toLower()) {}
+
+    int importTasks(const QString& inputName);
+    int exportTasks(const QString& outputName, const QString& query);
+    int printStatistics(const QString& query);
+    int compact();
+
+private:
+    QString dataDir;
+    QString formatName;
+
+    bool formatFor(const QString& fileName, Format* format) const;
+    bool openBoard(TaskFileReader& reader, DescriptionStore& descriptions) const;
+    bool checkNotInUse() const;
+    int fail(const QString& message) const;
+};
+
+int TaskCtl::importTasks(const QString& inputName)
+{
+    Format format;
+    if (!formatFor(inputName, &format) || !checkNotInUse()) return 1;
+
+    QFile input;
+    if (!openInput(input, inputName)) return fail(QString("Cannot read %1: %2").arg(inputName, input.errorString()));
+
+    DescriptionStore descriptions;
+    descriptions.open(dataPath(dataDir, DescriptionFileName));
+    QString taskPath = dataPath(dataDir, TaskFileName);
+    TaskFileWriter writer;
+    if (!writer.open(taskPath)) return fail(QString("Cannot write %1: %2").arg(taskPath, writer.errorString()));
+
+    // The board is copied first; its ids are kept to skip rows that are already there
+    std::vector<TaskId> existingIds;
+    QHash<TaskId, int> levels;
+    auto rememberLevel = [&levels](const Task& task) {
+        if (levels.size() >= LevelCacheSize) levels.clear();
+        levels.insert(task.id, task.level);
+    };
+
+    TaskFileReader reader;
+    if (reader.open(taskPath)) {
+        Task task;
+        while (reader.next(task)) {
+            writer.write(task);
+            existingIds.push_back(task.id);
+            rememberLevel(task);
+        }
+        if (reader.hasError()) return fail(QString("%1: %2").arg(taskPath, reader.errorString()));
+        reader.close();
+    }
+    std::sort(existingIds.begin(), existingIds.end());
+    QSet<TaskId> recentIds; // Repeated rows in the input go in once
+    auto mergeRecentIds = [&existingIds, &recentIds]() {
+        auto middle = existingIds.insert(existingIds.end(), recentIds.begin(), recentIds.end());
+        std::sort(middle, existingIds.end());
+        std::inplace_merge(existingIds.begin(), middle, existingIds.end());
+        recentIds.clear();
+    };
+
+    RecordReader records(input, format);
+    QString error;
+    if (!records.readHeader(&error)) return fail(error);
+
+    Throughput throughput("Imported");
+    qint64 skipped = 0;
+    qint64 malformed = 0;
+    Task task;
+    while (records.next(task, &error)) {
+        if (!error.isEmpty()) {
+            if (++malformed <= MaxReportedErrors) err() << inputName << ": " << error << "\n";
+            continue;
+        }
+        if (std::binary_search(existingIds.begin(), existingIds.end(), task.id) || recentIds.contains(task.id)) {
+            skipped++;
+            continue;
+        }
+        recentIds.insert(task.id);
+        if (recentIds.size() >= IdMergeBatch) {
+            mergeRecentIds();
+        }
+
+        // A parent not seen recently gets its level fixed when the window loads the file
+        if (task.parentId.isNull()) {
+            task.level = 0;
+        } else {
+            task.level = levels.contains(task.parentId) ? levels.value(task.parentId) + 1 : 1;
+        }
+        descriptions.store(task, task.description);
+        writer.write(task);
+        rememberLevel(task);
+        throughput.row();
+    }
+
+    if (!writer.commit()) return fail(QString("Cannot write %1: %2").arg(taskPath, writer.errorString()));
+    throughput.finish();
+    if (skipped > 0) err() << "Skipped " << skipped << " rows whose id is already on the board or earlier in the input\n";
+    if (malformed > 0) err() << "Skipped " << malformed << " malformed rows\n";
+    return 0;
+}
+
+int TaskCtl::exportTasks(const QString& outputName, const QString& query)
+{
+    Format format;
+    if (!formatFor(outputName, &format)) return 1;
+
+    TaskFileReader reader;
+    DescriptionStore descriptions;
+    if (!openBoard(reader, descriptions)) return 1;
+
+    QFile output;
+    if (!openOutput(output, outputName)) return fail(QString("Cannot write %1: %2").arg(outputName, output.errorString()));
+
+    RecordWriter records(output, format, descriptions);
+    Throughput throughput(query.isEmpty() ? "Exported" : "Matched");
+    QString error;
+    bool ok = forEachTask(reader, query, [&](const Task& task) {
+        records.write(task);
+        throughput.row();
+    }, &error);
+    output.close();
+    if (!ok) return fail(error);
+    throughput.finish();
+    return 0;
+}
+
+int TaskCtl::printStatistics(const QString& query)
+{
+    TaskFileReader reader;
+    DescriptionStore descriptions;
+    if (!openBoard(reader, descriptions)) return 1;
+
+    TaskStats stats;
+    QStringList priorities = {"High", "Medium", "Low"};
+    QString error;
+    bool ok = forEachTask(reader, query, [&](const Task& task) {
+        stats.addTask(task, TaskId()); // Per-root progress is not reported
+        if (!priorities.contains(task.priority)) priorities.append(task.priority);
+    }, &error);
+    if (!ok) return fail(error);
+
+    QTextStream out(stdout);
+    out << "Tasks:          " << stats.totalCount() << "\n"
+        << "Completed:      " << stats.completedCount() << " (" << stats.completionPercent() << "%)\n"
+        << "Pending:        " << stats.pendingCount() << "\n"
+        << "Overdue:        " << stats.dueCount(TaskStats::Overdue) << "\n"
+        << "Due today:      " << stats.dueCount(TaskStats::DueToday) << "\n"
+        << "Due this week:  " << stats.dueCount(TaskStats::DueThisWeek) << "\n";
+    for (const QString& priority : priorities) {
+        out << QString("%1 priority:").arg(priority).leftJustified(16) << stats.priorityCount(priority) << "\n";
+    }
+    return 0;
+}
+
+int TaskCtl::compact()
+{
+    if (!checkNotInUse()) return 1;
+
+    QString taskPath = dataPath(dataDir, TaskFileName);
+    DescriptionStore descriptions;
+    descriptions.open(dataPath(dataDir, DescriptionFileName));
+    qint64 blobBefore = descriptions.fileSize();
+
+    // As in the window: the board is saved self-contained first, so a crash while
+    // the blob is rewritten loses nothing
+    for (int pass = 0; pass < 2; ++pass) {
+        TaskFileReader reader;
+        if (!reader.open(taskPath)) return fail(QString("Cannot read %1: %2").arg(taskPath, reader.errorString()));
+        TaskFileWriter writer;
+        if (!writer.open(taskPath)) return fail(QString("Cannot write %1: %2").arg(taskPath, writer.errorString()));
+
+        Throughput throughput(pass == 0 ? "Inlined" : "Compacted");
+        Task task;
+        while (reader.next(task)) {
+            if (pass == 0) {
+                task.description = descriptions.text(task);
+                task.descriptionOffset = -1;
+                task.descriptionSize = 0;
+            } else if (!task.description.isEmpty()) {
+                descriptions.store(task, task.description);
+            }
+            writer.write(task);
+            throughput.row();
+        }
+        if (reader.hasError()) return fail(QString("%1: %2").arg(taskPath, reader.errorString()));
+        reader.close();
+        if (!writer.commit()) return fail(QString("Cannot write %1: %2").arg(taskPath, writer.errorString()));
+        throughput.finish();
+
+        if (pass == 0) {
+            descriptions.clear();
+        }
+    }
+
+    err() << "Description blob: " << blobBefore << " -> " << descriptions.fileSize() << " bytes\n";
+    return 0;
+}
+
+bool TaskCtl::formatFor(const QString& fileName, Format* format) const
+{
+    QString name = formatName;
+    if (name.isEmpty()) {
+        name = QFileInfo(fileName).suffix().toLower() == "csv" ? "csv" : "ndjson";
+    }
+    if (name == "csv") {
+        *format = Format::Csv;
+    } else if (name == "ndjson" || name == "jsonl") {
+        *format = Format::Ndjson;
+    } else {
+        fail(QString("Unknown format %1; use csv or ndjson").arg(formatName));
+        return false;
+    }
+    return true;
+}
+
+bool TaskCtl::openBoard(TaskFileReader& reader, DescriptionStore& descriptions) const
+{
+    QString taskPath = dataPath(dataDir, TaskFileName);
+    if (!reader.open(taskPath)) {
+        fail(QString("Cannot read %1: %2").arg(taskPath, reader.errorString()));
+        return false;
+    }
+    descriptions.open(dataPath(dataDir, DescriptionFileName));
+    if (hasJournal(dataDir)) {
+        err() << "Note: TaskManager has moves that are not in the task file yet; they are not included\n";
+    }
+    return true;
+}
+
+bool TaskCtl::checkNotInUse() const
+{
+    // Every open window listens on the board's sync socket, and would write its own
+    // copy of the board over ours on its next save
+    QLocalSocket socket;
+    socket.connectToServer(SyncMessage::serverName(dataPath(dataDir, TaskFileName)));
+    if (socket.waitForConnected(500)) {
+        fail(QString("TaskManager has %1 open; close it first").arg(dataDir));
+        return false;
+    }
+
+    // Left by a window that crashed before saving its moves
+    if (hasJournal(dataDir)) {
+        fail(QString("%1 has moves that are not saved yet; open and close TaskManager first").arg(dataDir));
+        return false;
+    }
+    return true;
+}
+
+int TaskCtl::fail(const QString& message) const
+{
+    err() << "taskctl: " << message << "\n" << Qt::flush;
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Bulk import, export, queries and maintenance for TaskManager task files.");
+    parser.addHelpOption();
+    QCommandLineOption dataDirOption("data-dir", "Task files in <dir> instead of TaskManager's data directory.", "dir");
+    QCommandLineOption formatOption("format", "csv or ndjson; by default from the file name, else ndjson.", "format");
+    parser.addOption(dataDirOption);
+    parser.addOption(formatOption);
+    parser.addPositionalArgument("command", "import FILE | export [FILE] | query EXPR [FILE] | stats [EXPR] | compact");
+    parser.process(app);
+
+    // The window's data directory is named after its executable
+    QCoreApplication::setApplicationName("TaskManager");
+    QString dataDir = parser.isSet(dataDirOption) ? parser.value(dataDirOption)
+                                                  : QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataDir);
+    dataDir = QDir(dataDir).absolutePath(); // Spelled as the window spells it, for the socket name
+
+    TaskCtl ctl(dataDir, parser.value(formatOption));
+    const QStringList args = parser.positionalArguments();
+    QString command = args.value(0);
+    if (command == "import" && args.size() == 2) return ctl.importTasks(args[1]);
+    if (command == "export" && args.size() <= 2) return ctl.exportTasks(args.value(1), QString());
+    if (command == "query" && (args.size() == 2 || args.size() == 3)) return ctl.exportTasks(args.value(2), args[1]);
+    if (command == "stats" && args.size() <= 2) return ctl.printStatistics(args.value(1));
+    if (command == "compact" && args.size() == 1) return ctl.compact();
+
+    parser.showHelp(1);
+}
@@ -0,0 +1,97 @@
+#include "undohistory.h"
+
+UndoHistory::UndoHistory(qint64 byteLimit, QObject* parent)
+    : QObject(parent), byteLimit(byteLimit)
+{
+}
+
+UndoHistory::~UndoHistory() = default;
+
+void UndoHistory::push(TaskCommand* command)
+{
+    command->redo();
+    append(command);
+}
+
+void UndoHistory::record(TaskCommand* command)
+{
+    append(command);
+}
+
+void UndoHistory::clear()
+{
+    if (commands.empty()) return;
+    commands.clear();
+    index = 0;
+    bytes = 0;
+    emit changed();
+}
+
+bool UndoHistory::canUndo() const
+{
+    return index > 0;
+}
+
+bool UndoHistory::canRedo() const
+{
+    return index < int(commands.size());
+}
+
+QString UndoHistory::undoText() const
+{
+    return canUndo() ? commands[index - 1]->text() : QString();
+}
+
+QString UndoHistory::redoText() const
+{
+    return canRedo() ? commands[index]->text() : QString();
+}
+
+int UndoHistory::count() const
+{
+    return int(commands.size());
+}
+
+qint64 UndoHistory::byteSize() const
+{
+    return bytes;
+}
+
+void UndoHistory::undo()
+{
+    if (!canUndo()) return;
+    commands[--index]->undo();
+    emit changed();
+}
+
+void UndoHistory::redo()
+{
+    if (!canRedo()) return;
+    commands[index++]->redo();
+    emit changed();
+}
+
+void UndoHistory::append(TaskCommand* command)
+{
+    // A new change ends whatever could have been redone
+    while (int(commands.size()) > index) {
+        bytes -= commands.back()->byteSize();
+        commands.pop_back();
+    }
+
+    commands.emplace_back(command);
+    bytes += command->byteSize();
+    index++;
+    trim();
+    emit changed();
+}
+
+void UndoHistory::trim()
+{
+    // The newest command stays even if it alone is over the limit
+    while (bytes > byteLimit && commands.size() > 1) {
+        bytes -= commands.front()->byteSize();
+        commands.pop_front();
+        index--;
+    }
+}
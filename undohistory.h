@@ -0,0 +1,48 @@
+#ifndef UNDOHISTORY_H
+#define UNDOHISTORY_H
+#include <QObject>
+#include <deque>
+#include <memory>
+#include "taskcommands.h"
+
+// Undo/redo stack for TaskCommands with a cap on the memory they hold, which
+// QUndoStack can only bound by command count. When a push goes over the cap the
+// oldest commands are dropped, so the history gets shorter instead of larger.
+// The commands are ordinary QUndoCommands and would work on a QUndoStack too.
+class UndoHistory : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UndoHistory(qint64 byteLimit, QObject* parent = nullptr);
+    ~UndoHistory() override;
+
+    void push(TaskCommand* command);   // Takes ownership and runs redo()
+    void record(TaskCommand* command); // Takes ownership of a change that is already applied
+    void clear();
+
+    bool canUndo() const;
+    bool canRedo() const;
+    QString undoText() const;
+    QString redoText() const;
+    int count() const;
+    qint64 byteSize() const;
+
+public slots:
+    void undo();
+    void redo();
+
+signals:
+    void changed();
+
+private:
+    std::deque<std::unique_ptr<TaskCommand>> commands;
+    int index = 0; // Commands below this have been applied
+    qint64 bytes = 0;
+    qint64 byteLimit;
+
+    void append(TaskCommand* command);
+    void trim();
+};
+
+#endif // UNDOHISTORY_H
@@ -0,0 +1,66 @@
+#include "versionvector.h"
+
+quint64 VersionVector::counter(quint64 peerId) const
+{
+    return counters.value(peerId, 0);
+}
+
+void VersionVector::increment(quint64 peerId)
+{
+    counters[peerId]++;
+}
+
+void VersionVector::merge(const VersionVector& other)
+{
+    for (auto it = other.counters.constBegin(); it != other.counters.constEnd(); ++it) {
+        quint64& counter = counters[it.key()];
+        counter = qMax(counter, it.value());
+    }
+}
+
+VersionVector::Ordering VersionVector::compare(const VersionVector& other) const
+{
+    bool behind = false;
+    bool ahead = false;
+    for (auto it = counters.constBegin(); it != counters.constEnd(); ++it) {
+        quint64 theirs = other.counter(it.key());
+        behind |= it.value() < theirs;
+        ahead |= it.value() > theirs;
+    }
+    for (auto it = other.counters.constBegin(); it != other.counters.constEnd(); ++it) {
+        behind |= counter(it.key()) < it.value();
+    }
+
+    if (behind && ahead) return Concurrent;
+    if (behind) return Before;
+    if (ahead) return After;
+    return Equal;
+}
+
+bool VersionVector::isEmpty() const
+{
+    return counters.isEmpty();
+}
+
+QDataStream& operator<<(QDataStream& out, const VersionVector& vector)
+{
+    out << quint32(vector.counters.size());
+    for (auto it = vector.counters.constBegin(); it != vector.counters.constEnd(); ++it) {
+        out << it.key() << it.value();
+    }
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, VersionVector& vector)
+{
+    vector.counters.clear();
+    quint32 count = 0;
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        quint64 peerId = 0;
+        quint64 counter = 0;
+        in >> peerId >> counter;
+        vector.counters.insert(peerId, counter);
+    }
+    return in;
+}
@@ -0,0 +1,27 @@
+#ifndef VERSIONVECTOR_H
+#define VERSIONVECTOR_H
+#include <QMap>
+#include <QDataStream>
+
+// One counter per writer, as used to order changes made by several instances.
+// A vector that is neither before nor after another marks concurrent writes,
+// which the caller resolves with its own rule.
+class VersionVector
+{
+public:
+    enum Ordering { Equal, Before, After, Concurrent };
+
+    quint64 counter(quint64 peerId) const;
+    void increment(quint64 peerId);
+    void merge(const VersionVector& other);
+    Ordering compare(const VersionVector& other) const;
+    bool isEmpty() const;
+
+    friend QDataStream& operator<<(QDataStream& out, const VersionVector& vector);
+    friend QDataStream& operator>>(QDataStream& in, VersionVector& vector);
+
+private:
+    QMap<quint64, quint64> counters; // Ordered, so the encoding is canonical
+};
+
+#endif // VERSIONVECTOR_H